@@ -0,0 +1,189 @@
+// Linux serial gateway: drives one TuyaWaterQuality per serial device from a
+// single epoll loop and writes every reading as a JSON line to stdout.
+//
+//   linux_gateway /dev/ttyUSB0 /dev/ttyUSB1 ... > readings.jsonl
+//
+// Built with `pio run -e native_linux_gateway`, against the Arduino stubs
+// with millis() on the monotonic clock. example/linux_simulator.cpp provides
+// simulated sensors on pseudo-terminals to run it against.
+
+#include <Arduino.h>
+#include <tuya_water_quality.h>
+#include <tuya_fd_stream.h>
+
+#include <memory>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <vector>
+
+const uint32_t BAUD = 9600;
+const int TICK_MS = 100;
+const int MAX_EVENTS = 64;
+
+// Where readings go; replace JsonLinesOutput to publish elsewhere (MQTT, a
+// database, ...).
+class GatewayOutput
+{
+public:
+    virtual ~GatewayOutput() {}
+    virtual void reading(const char *device, const TuyaEvent &event, const TuyaWaterQualitySensorData &data) = 0;
+    virtual void linkError(const char *device, TuyaError error) = 0;
+    virtual void flush() {}
+};
+
+class JsonLinesOutput : public GatewayOutput
+{
+public:
+    void reading(const char *device, const TuyaEvent &event, const TuyaWaterQualitySensorData &data) override
+    {
+        const TuyaSensorValue *value = channel(event.dp, data);
+        if (value == nullptr)
+            return;
+        printf("{\"ts\":%lu,\"device\":\"%s\",\"dp\":%u,\"event\":\"%s\",\"value\":%g,\"filtered\":%g,\"min\":%g,\"max\":%g}\n",
+               static_cast<unsigned long>(millis()), device, event.dp,
+               event.type == TuyaEventType::ThresholdChange ? "threshold" : "reading",
+               value->value, value->filtered, value->minThreshold, value->maxThreshold);
+    }
+
+    void linkError(const char *device, TuyaError error) override
+    {
+        printf("{\"ts\":%lu,\"device\":\"%s\",\"error\":%d}\n",
+               static_cast<unsigned long>(millis()), device, static_cast<int>(error));
+    }
+
+    void flush() override
+    {
+        fflush(stdout);
+    }
+
+private:
+    static const TuyaSensorValue *channel(uint8_t dp, const TuyaWaterQualitySensorData &data)
+    {
+        switch (static_cast<TuyaWaterQualityDp>(dp))
+        {
+        case TuyaWaterQualityDp::Temperature:
+        case TuyaWaterQualityDp::HighTemperatureThreshold:
+        case TuyaWaterQualityDp::LowTemperatureThreshold:
+            return &data.temperature;
+        case TuyaWaterQualityDp::PH:
+        case TuyaWaterQualityDp::HighPHThreshold:
+        case TuyaWaterQualityDp::LowPHThreshold:
+            return &data.ph;
+        case TuyaWaterQualityDp::TDS:
+        case TuyaWaterQualityDp::HighTDSThreshold:
+        case TuyaWaterQualityDp::LowTDSThreshold:
+            return &data.tds;
+        default:
+            return nullptr;
+        }
+    }
+};
+
+struct Device
+{
+    const char *path;
+    TuyaFdStream stream;
+    TuyaWaterQuality sensor;
+    GatewayOutput *output;
+};
+
+volatile sig_atomic_t running = 1;
+
+void onSignal(int)
+{
+    running = 0;
+}
+
+void onEvent(void *context, const TuyaEvent &event)
+{
+    Device *device = static_cast<Device *>(context);
+    if (event.type == TuyaEventType::LinkError)
+        device->output->linkError(device->path, event.error);
+    else if (event.view != nullptr)
+        device->output->reading(device->path, event, *static_cast<const TuyaWaterQualitySensorData *>(event.view));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <serial device>...\n", argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    JsonLinesOutput output;
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0)
+    {
+        perror("epoll_create1");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Device>> devices;
+    for (int i = 1; i < argc; i++)
+    {
+        std::unique_ptr<Device> device(new Device());
+        device->path = argv[i];
+        device->output = &output;
+        if (!device->stream.open(argv[i], BAUD))
+        {
+            perror(argv[i]);
+            continue;
+        }
+
+        // loop() must not sleep: the epoll wait is the only place this process blocks
+        device->sensor.begin(&device->stream);
+        device->sensor.setDelay(0);
+        device->sensor.subscribe(tuyaEventMask(TuyaEventType::DpUpdate) |
+                                     tuyaEventMask(TuyaEventType::ThresholdChange) |
+                                     tuyaEventMask(TuyaEventType::LinkError),
+                                 onEvent, device.get());
+
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = device.get();
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, device->stream.getFd(), &event) != 0)
+        {
+            perror("epoll_ctl");
+            continue;
+        }
+        devices.push_back(std::move(device));
+    }
+    fprintf(stderr, "gateway: %zu device(s)\n", devices.size());
+
+    struct epoll_event events[MAX_EVENTS];
+    unsigned long lastTick = millis();
+    while (running && !devices.empty())
+    {
+        int count = epoll_wait(epoll, events, MAX_EVENTS, TICK_MS);
+        for (int i = 0; i < count; i++)
+        {
+            Device *device = static_cast<Device *>(events[i].data.ptr);
+            device->stream.fill();
+            device->sensor.loop();
+        }
+
+        // Heartbeats and handshake retries are time driven, so every device
+        // also gets a loop() per tick even when it is silent
+        if (millis() - lastTick >= static_cast<unsigned long>(TICK_MS))
+        {
+            lastTick = millis();
+            for (std::unique_ptr<Device> &device : devices)
+            {
+                device->sensor.loop();
+            }
+        }
+        output.flush();
+    }
+
+    for (std::unique_ptr<Device> &device : devices)
+    {
+        fprintf(stderr, "%s: initialized %d, write drops %u\n", device->path, device->sensor.isInitialized(),
+                device->stream.getWriteDrops());
+    }
+    return 0;
+}
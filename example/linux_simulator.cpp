@@ -0,0 +1,77 @@
+// Simulated sensor boards on pseudo-terminals, for load testing
+// example/linux_gateway.cpp without hardware:
+//
+//   linux_simulator 200 10 > ptys.txt &   # 200 boards, a report every 10 ms
+//   linux_gateway $(cat ptys.txt)
+//
+// Built with `pio run -e native_linux_simulator`.
+
+#include <Arduino.h>
+#include <tuya_water_quality.h>
+#include <tuya_fd_stream.h>
+#include <tuya_mcu_simulator.h>
+
+#include <memory>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+struct Board
+{
+    TuyaFdStream stream;
+    TuyaMcuSimulator simulator;
+};
+
+volatile sig_atomic_t running = 1;
+
+void onSignal(int)
+{
+    running = 0;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1;
+    uint32_t reportIntervalMs = argc > 2 ? atoi(argv[2]) : 1000;
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    std::vector<std::unique_ptr<Board>> boards;
+    for (int i = 0; i < count; i++)
+    {
+        std::unique_ptr<Board> board(new Board());
+        char slaveName[64];
+        if (!board->stream.openPty(slaveName, sizeof(slaveName)))
+        {
+            perror("openPty");
+            return 1;
+        }
+
+        TuyaMcuSimulatorConfig config = {};
+        config.productInfo = "{\"product_id\":\"simulated\",\"version\":\"1.0.0\",\"operation_mode\":0}";
+        config.reportIntervalMs = reportIntervalMs;
+        config.reportBurst = 1;
+        config.seed = i + 1;
+        board->simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::Temperature), 250 + i % 50, 3);
+        board->simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::PH), 700, 15);
+        board->simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::TDS), 300, 20);
+        board->simulator.begin(&board->stream, config);
+
+        printf("%s\n", slaveName);
+        boards.push_back(std::move(board));
+    }
+    fflush(stdout);
+
+    while (running)
+    {
+        for (std::unique_ptr<Board> &board : boards)
+        {
+            board->simulator.poll();
+        }
+        usleep(1000);
+    }
+    return 0;
+}
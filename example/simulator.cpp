@@ -0,0 +1,78 @@
+#include <Arduino.h>
+#include <tuya_water_quality.h>
+#include <tuya_mcu_simulator.h>
+
+// Load test: the library talks to a simulated sensor board over an in-memory
+// link, so no hardware is needed. Raise reportBurst / lower reportIntervalMs
+// until updates per second stop growing or link errors appear.
+
+TuyaMcuSimulator simulator;
+TuyaWaterQuality waterQuality;
+
+uint32_t updates = 0;
+uint32_t linkErrors = 0;
+
+void onEvent(void *, const TuyaEvent &event)
+{
+    if (event.type == TuyaEventType::LinkError)
+        linkErrors++;
+    else
+        updates++;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+
+    TuyaMcuSimulatorConfig config = {
+        .productInfo = "{\"product_id\":\"simulated\",\"version\":\"1.0.0\",\"operation_mode\":0}",
+        .reportIntervalMs = 10,
+        .reportBurst = 3,
+        .corruptPerMille = 1,
+        .maxChunk = 24,
+        .latencyMs = 5,
+        .seed = 1,
+    };
+    simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::Temperature), 253, 3);
+    simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::PH), 701, 15);
+    simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::TDS), 300, 20);
+    simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::HighPHThreshold), 800, 0);
+    simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::LowPHThreshold), 600, 0);
+    simulator.begin(config);
+
+    waterQuality.begin(&simulator.getModuleStream());
+    waterQuality.setDelay(0);
+    waterQuality.subscribe(tuyaEventMask(TuyaEventType::DpUpdate) |
+                               tuyaEventMask(TuyaEventType::ThresholdChange) |
+                               tuyaEventMask(TuyaEventType::LinkError),
+                           onEvent, nullptr);
+}
+
+void loop()
+{
+    simulator.poll();
+    waterQuality.loop();
+
+    static uint32_t lastPrint = 0;
+    if (millis() - lastPrint >= 1000)
+    {
+        lastPrint = millis();
+        const TuyaMcuSimulatorStats &stats = simulator.getStats();
+
+        Serial.print("sent: ");
+        Serial.print(stats.framesSent);
+        Serial.print(", dropped bytes: ");
+        Serial.print(stats.bytesDropped);
+        Serial.print(", corrupted bytes: ");
+        Serial.print(stats.bytesCorrupted);
+        Serial.print(", updates: ");
+        Serial.print(updates);
+        Serial.print(", link errors: ");
+        Serial.print(linkErrors);
+        Serial.print(", pH: ");
+        Serial.println(waterQuality.getPh());
+
+        updates = 0;
+        linkErrors = 0;
+    }
+}
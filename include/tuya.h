@@ -2,6 +2,12 @@
 
 #include <Arduino.h>
 #include <Stream.h>
+#include <tuya_config.h>
+#include <tuya_ota.h>
+#include <tuya_rx_buffer.h>
+#include <tuya_event_bus.h>
+#include <tuya_state_store.h>
+#include <tuya_tx_queue.h>
 
 // =======================
 // Enums
@@ -79,16 +85,24 @@ enum class TuyaNetworkStatus : uint8_t
 // Structs
 // =======================
 
-struct TuyaFrame
+template <uint16_t Capacity>
+struct TuyaFrameBuffer
 {
+  static constexpr uint16_t capacity = Capacity;
+
   uint8_t header[2];
   uint8_t version;
   uint8_t command;
   uint8_t length[2];
-  uint8_t data[1024];
+  uint8_t data[Capacity];
   uint8_t checksum;
 };
 
+// Frames received from the MCU and frames built for sending are sized
+// separately, see tuya_config.h
+typedef TuyaFrameBuffer<TUYA_RX_FRAME_CAPACITY> TuyaFrame;
+typedef TuyaFrameBuffer<TUYA_TX_FRAME_CAPACITY> TuyaTxFrame;
+
 struct TuyaProductInfo
 {
   String productId;
@@ -104,6 +118,7 @@ struct TuyaModuleInfo
   bool productInfoReceived;
   bool workingModeReceived;
   bool initialized;
+  bool restored;
 };
 
 // =======================
@@ -117,20 +132,45 @@ public:
 
   // Core API
   void begin(Stream *serial);
+  void begin(Stream *serial, TuyaRxBuffer *rxBuffer);
   void loop();
 
   // Configuration
   void enableDebug(Stream &debugStream, bool enable);
   void setDelay(uint32_t delayMs);
   void setNetworkStatus(TuyaNetworkStatus status);
+  // Outgoing frames are queued and sent from loop() at this rate, see
+  // TuyaTxQueue; 0 bytes per second sends everything queued at once
+  void setTxRate(uint16_t bytesPerSecond, uint16_t burstBytes);
+
+  // Warm start: restore the handshake and last readings from `store` at
+  // begin() and keep it updated, at most every saveIntervalMs. Call before
+  // begin().
+#if TUYA_ENABLE_WARM_START
+  void setStateStore(TuyaStateStore *store, uint32_t saveIntervalMs = 60000);
+#endif
 
   // State
+  // Initialized once the handshake completed or a valid state was restored;
+  // verified only once the MCU itself answered the handshake since boot
   bool isInitialized() const;
+  bool isVerified() const;
+  bool isRestored() const;
   TuyaNetworkStatus getNetworkStatus() const;
   TuyaProductInfo getProductInfo() const;
+  const TuyaTxStats &getTxStats() const;
+
+#if TUYA_ENABLE_OTA
+  // OTA
+  bool startOta(TuyaOtaSource &source, uint32_t timeoutMs = 5000, uint8_t maxRetries = 3);
+  void abortOta();
+  const TuyaOta &getOta() const;
+#endif
 
   // Event
   void onResetWiFiPairMode(void (*callback)());
+  int8_t subscribe(uint8_t eventMask, TuyaEventHandler handler, void *context, const TuyaDpFilter &filter = TuyaDpFilter::all());
+  bool unsubscribe(int8_t id);
 
 protected:
   // Decoding
@@ -138,29 +178,85 @@ protected:
   virtual bool decodeProductInfo(TuyaFrame &frame);
   virtual bool decodeQueryWorkingMode(TuyaFrame &frame);
   virtual bool decodeReportStatusAsync(TuyaFrame &frame);
+  // Called by decodeReportStatusAsync() for each DP of a report; publishes a
+  // DpUpdate event by default
+  virtual bool decodeDp(uint8_t dp, TuyaDataType dataType, const uint8_t *value, uint16_t valueLength);
+
+  // Called once per loop() after incoming frames are decoded
+  virtual void poll();
 
   // Frame helpers
-  TuyaFrame createFrame(TuyaDeviceType deviceType, TuyaCommand command, uint8_t *data, uint16_t dataLength) const;
-  TuyaFrame createFrame(TuyaDeviceType deviceType, TuyaCommand command) const;
-  bool sendFrame(const TuyaFrame &frame) const;
+  TuyaTxFrame createFrame(TuyaDeviceType deviceType, TuyaCommand command, uint8_t *data, uint16_t dataLength) const;
+  TuyaTxFrame createFrame(TuyaDeviceType deviceType, TuyaCommand command) const;
+  template <size_t Length>
+  TuyaTxFrame createFrame(TuyaDeviceType deviceType, TuyaCommand command, uint8_t (&data)[Length]) const
+  {
+    static_assert(Length <= TuyaTxFrame::capacity, "payload exceeds TUYA_TX_FRAME_CAPACITY");
+    return createFrame(deviceType, command, data, Length);
+  }
+  bool sendFrame(const TuyaTxFrame &frame) const;
+  // Queued for the next loop(); false when dropped
+  bool queueFrame(const TuyaTxFrame &frame, TuyaTxPriority priority = TuyaTxPriority::Normal);
+
+  // Event helpers
+  TuyaEvent createEvent(TuyaEventType type) const;
+  void publishEvent(const TuyaEvent &event) const;
+
+  // Warm start: subclass state appended to the persisted record
+#if TUYA_ENABLE_WARM_START
+  virtual uint16_t saveState(uint8_t *data, uint16_t capacity) const;
+  virtual bool restoreState(const uint8_t *data, uint16_t length);
+#endif
+  void markStateDirty();
 
 private:
   // Serial
   Stream *_serial = nullptr;
   Stream *_debugStream = nullptr;
+  TuyaRxBuffer *_rxBuffer = nullptr;
+
+  // Receive
+  TuyaFrame _rxFrame;
+  uint16_t _rxIndex = 0;
+  uint8_t _rxChecksum = 0;
+  uint8_t _rxChunk[32];
+  uint8_t _rxChunkPos = 0;
+  uint8_t _rxChunkLen = 0;
+
+  // Transmit
+  TuyaTxQueue<TuyaTxFrame, TUYA_TX_QUEUE_SIZE> _txQueue;
 
   // State
   TuyaModuleInfo _moduleInfo;
   uint32_t _delayMs = 250;
   uint32_t _heartbeatIntervalMs = 1000;
   uint32_t _lastHeartbeatMs = 0;
+  uint32_t _lastVerifyMs = 0;
   bool _debugEnabled = false;
   void (*_resetWiFiPairModeCallback)() = nullptr;
+#if TUYA_ENABLE_OTA
+  TuyaOta _ota;
+#endif
+#if TUYA_ENABLE_EVENTS
+  TuyaEventBus _eventBus;
+#endif
+#if TUYA_ENABLE_WARM_START
+  TuyaStateStore *_stateStore = nullptr;
+  uint32_t _stateSaveIntervalMs = 60000;
+  uint32_t _lastStateSaveMs = 0;
+  bool _stateDirty = false;
+#endif
 
   // Internal helpers
   TuyaError receiveMessage(TuyaFrame &frame);
-  bool validateChecksum(const TuyaFrame &frame) const;
-  uint8_t calculateChecksum(const TuyaFrame &frame) const;
+  TuyaError parseByte(TuyaFrame &frame, uint8_t byte);
+  bool fillReceiveChunk();
+  uint8_t calculateChecksum(const TuyaTxFrame &frame) const;
+  void flushTxQueue();
+#if TUYA_ENABLE_WARM_START
+  void restoreStateRecord();
+  void saveStateRecord();
+#endif
 
   void decodeFrame(TuyaFrame &frame);
   void printFrame(const TuyaFrame &frame) const;
@@ -173,15 +269,16 @@ private:
   void handleReportStatusAsync(TuyaFrame &frame);
   void handleGetCurrentNetworkStatus(TuyaFrame &frame);
   void handleResetWiFiPairMode(TuyaFrame &frame);
+#if TUYA_ENABLE_OTA
+  void handleStartOta(TuyaFrame &frame);
+  void handleTransmitOtaData(TuyaFrame &frame);
+#endif
   void handleUnknownCommand(TuyaFrame &frame);
 
   // Communication
-  void sendNetworkStatus() const;
-  void reportNetworkStatus() const;
-  void sendHeartbeats() const;
-  void queryProductInfo() const;
-  void queryWorkingMode() const;
-
-  // Utility
-  String dataToString(uint8_t *data, uint16_t length) const;
+  void sendNetworkStatus();
+  void reportNetworkStatus();
+  void sendHeartbeats();
+  void queryProductInfo();
+  void queryWorkingMode();
 };
\ No newline at end of file
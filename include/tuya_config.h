@@ -0,0 +1,89 @@
+#pragma once
+
+// Compile-time configuration. Override with build flags, e.g. in
+// platformio.ini: build_flags = -DTUYA_RX_FRAME_CAPACITY=128 -DTUYA_ENABLE_OTA=0
+
+// Largest payload accepted from the MCU. Longer frames are dropped with
+// TuyaError::Overflow. The product info JSON is the largest frame the sensor
+// sends.
+#ifndef TUYA_RX_FRAME_CAPACITY
+#define TUYA_RX_FRAME_CAPACITY 256
+#endif
+
+// Largest payload the module builds with createFrame(). OTA packets are
+// streamed and do not count against it.
+#ifndef TUYA_TX_FRAME_CAPACITY
+#define TUYA_TX_FRAME_CAPACITY 32
+#endif
+
+// Firmware update of the MCU (TuyaOta)
+#ifndef TUYA_ENABLE_OTA
+#define TUYA_ENABLE_OTA 1
+#endif
+
+// Multi-subscriber event bus (TuyaEventBus)
+#ifndef TUYA_ENABLE_EVENTS
+#define TUYA_ENABLE_EVENTS 1
+#endif
+
+// Restoring the handshake and last readings after a reset (TuyaStateStore)
+#ifndef TUYA_ENABLE_WARM_START
+#define TUYA_ENABLE_WARM_START 1
+#endif
+
+// Outgoing frames waiting for loop(); when full, the lowest priority frame
+// that is not a DP write is dropped. One slot is kept for heartbeats and
+// network status replies (TuyaTxQueue).
+#ifndef TUYA_TX_QUEUE_SIZE
+#define TUYA_TX_QUEUE_SIZE 8
+#endif
+
+// Token bucket for outgoing bytes, about half of a 9600-baud link by
+// default. A rate of 0 disables the limiter.
+#ifndef TUYA_TX_RATE_BYTES_PER_SECOND
+#define TUYA_TX_RATE_BYTES_PER_SECOND 480
+#endif
+
+#ifndef TUYA_TX_BURST_BYTES
+#define TUYA_TX_BURST_BYTES 96
+#endif
+
+// Per-channel filter of tuya_filter.h applied to every reading before it is
+// stored in `filtered`, e.g. -DTUYA_PH_FILTER="TuyaMedianFilter<5>"
+#ifndef TUYA_TEMPERATURE_FILTER
+#define TUYA_TEMPERATURE_FILTER TuyaNoFilter
+#endif
+
+#ifndef TUYA_PH_FILTER
+#define TUYA_PH_FILTER TuyaNoFilter
+#endif
+
+#ifndef TUYA_TDS_FILTER
+#define TUYA_TDS_FILTER TuyaNoFilter
+#endif
+
+// Handlers that can subscribe to the event bus at the same time
+#ifndef TUYA_EVENT_MAX_SUBSCRIBERS
+#define TUYA_EVENT_MAX_SUBSCRIBERS 4
+#endif
+
+// ...Async requests of TuyaWaterQuality that can be pending at once
+#ifndef TUYA_MAX_PENDING_REQUESTS
+#define TUYA_MAX_PENDING_REQUESTS 4
+#endif
+
+// DPs served by TuyaMcuSimulator and the bytes buffered in each direction of
+// its in-memory link
+#ifndef TUYA_SIMULATOR_MAX_DPS
+#define TUYA_SIMULATOR_MAX_DPS 16
+#endif
+
+#ifndef TUYA_SIMULATOR_PIPE_SIZE
+#define TUYA_SIMULATOR_PIPE_SIZE 1024
+#endif
+
+static_assert(TUYA_RX_FRAME_CAPACITY >= 8 && TUYA_RX_FRAME_CAPACITY <= 0xFFFF - 7, "TUYA_RX_FRAME_CAPACITY out of range");
+static_assert(TUYA_TX_FRAME_CAPACITY >= 8 && TUYA_TX_FRAME_CAPACITY <= 0xFFFF - 7, "TUYA_TX_FRAME_CAPACITY out of range");
+static_assert(TUYA_TX_QUEUE_SIZE >= 1 && TUYA_TX_QUEUE_SIZE <= 255, "TUYA_TX_QUEUE_SIZE out of range");
+static_assert(TUYA_EVENT_MAX_SUBSCRIBERS >= 1 && TUYA_EVENT_MAX_SUBSCRIBERS <= 127, "TUYA_EVENT_MAX_SUBSCRIBERS out of range");
+static_assert(TUYA_MAX_PENDING_REQUESTS >= 1 && TUYA_MAX_PENDING_REQUESTS <= 255, "TUYA_MAX_PENDING_REQUESTS out of range");
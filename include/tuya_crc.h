@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Arduino.h>
+
+// =======================
+// CRC-32
+// =======================
+
+// CRC-32 (IEEE 802.3), bitwise to avoid a lookup table. Start from
+// TUYA_CRC32_INIT, feed the data in any number of pieces and invert the
+// result: ~tuyaCrc32Update(TUYA_CRC32_INIT, data, length).
+constexpr uint32_t TUYA_CRC32_INIT = 0xFFFFFFFF;
+
+uint32_t tuyaCrc32Update(uint32_t crc, const uint8_t *data, size_t length);
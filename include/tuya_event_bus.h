@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include <tuya_config.h>
+
+enum class TuyaError;
+enum class TuyaDataType : uint8_t;
+enum class TuyaNetworkStatus : uint8_t;
+
+// =======================
+// Enums
+// =======================
+
+enum class TuyaEventType : uint8_t
+{
+  DpUpdate = 0,
+  ThresholdChange,
+  NetworkStatus,
+  LinkError,
+  ResetWiFiPairMode,
+};
+
+constexpr uint8_t tuyaEventMask(TuyaEventType type)
+{
+  return 1 << static_cast<uint8_t>(type);
+}
+
+constexpr uint8_t TUYA_EVENT_MASK_ALL = 0xFF;
+
+// =======================
+// Structs
+// =======================
+
+// Everything an event carries is borrowed from the publisher and only valid
+// for the duration of the handler call. `view` points at the publisher's
+// decoded state (e.g. a const TuyaWaterQualitySensorData) when it has one.
+struct TuyaEvent
+{
+  TuyaEventType type;
+  uint8_t dp;
+  TuyaDataType dataType;
+  const uint8_t *value;
+  uint16_t valueLength;
+  TuyaNetworkStatus networkStatus;
+  TuyaError error;
+  const void *view;
+};
+
+// Set of DP ids a subscriber wants; only applied to events that carry a DP.
+struct TuyaDpFilter
+{
+  uint32_t bits[8];
+
+  static TuyaDpFilter all();
+  static TuyaDpFilter none();
+
+  TuyaDpFilter &add(uint8_t dp);
+  bool matches(uint8_t dp) const;
+};
+
+typedef void (*TuyaEventHandler)(void *context, const TuyaEvent &event);
+
+// =======================
+// TuyaEventBus Class
+// =======================
+
+// Fixed-capacity, allocation-free publish/subscribe. Handlers run
+// synchronously from loop() in subscription order.
+class TuyaEventBus
+{
+public:
+  TuyaEventBus();
+
+  int8_t subscribe(uint8_t eventMask, TuyaEventHandler handler, void *context, const TuyaDpFilter &filter);
+  bool unsubscribe(int8_t id);
+  void publish(const TuyaEvent &event) const;
+
+  uint8_t getSubscriberCount() const;
+
+private:
+  struct Subscriber
+  {
+    TuyaEventHandler handler;
+    void *context;
+    TuyaDpFilter filter;
+    uint8_t eventMask;
+  };
+
+  Subscriber _subscribers[TUYA_EVENT_MAX_SUBSCRIBERS];
+};
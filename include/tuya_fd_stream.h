@@ -0,0 +1,55 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <Arduino.h>
+#include <Stream.h>
+
+// =======================
+// TuyaFdStream Class
+// =======================
+
+// Stream over a non-blocking file descriptor for host builds on Linux: a
+// USB-UART device configured raw 8N1 through termios, or the master side of
+// a pseudo-terminal. Reads are buffered; fill() pulls whatever the kernel
+// has, which is what an epoll loop calls when the descriptor becomes
+// readable. A write the kernel cannot take at once (its buffer only fills
+// when the other end stops reading) waits up to the write timeout for the
+// descriptor to drain; bytes still left are counted in getWriteDrops() and
+// the short count is returned.
+class TuyaFdStream : public Stream
+{
+public:
+  TuyaFdStream();
+  ~TuyaFdStream();
+
+  bool open(const char *path, uint32_t baud);
+  bool openPty(char *slaveName, size_t slaveNameLength);
+  bool attach(int fd);
+  void close();
+
+  int getFd() const;
+  size_t fill();
+  uint32_t getWriteDrops() const;
+  void setWriteTimeout(uint32_t timeoutMs);
+
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void flush() override;
+
+private:
+  int _fd;
+  uint8_t _buffer[256];
+  uint16_t _head;
+  uint16_t _tail;
+  uint32_t _writeDrops;
+  uint32_t _writeTimeoutMs;
+
+  bool configureRaw(uint32_t baud);
+};
+
+#endif
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Denoising stages for the fixed-point DP values (temperature x10, pH x100,
+// TDS x1). Every filter has `int32_t update(int32_t sample)` returning the
+// filtered value in the same units, and is selected at compile time, see
+// TUYA_TEMPERATURE_FILTER and friends in tuya_config.h.
+
+// =======================
+// TuyaNoFilter
+// =======================
+
+class TuyaNoFilter
+{
+public:
+  int32_t update(int32_t sample) { return sample; }
+};
+
+// =======================
+// TuyaMedianFilter
+// =======================
+
+// Median of the last Size samples. The window is kept sorted; each update
+// finds the outgoing and incoming positions by binary search and shifts at
+// most Size - 1 entries.
+template <uint8_t Size>
+class TuyaMedianFilter
+{
+  static_assert(Size > 0, "median window must not be empty");
+
+public:
+  int32_t update(int32_t sample)
+  {
+    if (_count == Size)
+    {
+      uint8_t index = lowerBound(_history[_oldest], _count);
+      memmove(_sorted + index, _sorted + index + 1, (_count - index - 1) * sizeof(int32_t));
+      _count--;
+    }
+
+    uint8_t index = lowerBound(sample, _count);
+    memmove(_sorted + index + 1, _sorted + index, (_count - index) * sizeof(int32_t));
+    _sorted[index] = sample;
+    _count++;
+
+    _history[_oldest] = sample;
+    _oldest = (_oldest + 1) % Size;
+    return _sorted[_count / 2];
+  }
+
+private:
+  int32_t _history[Size] = {};
+  int32_t _sorted[Size] = {};
+  uint8_t _count = 0;
+  uint8_t _oldest = 0;
+
+  uint8_t lowerBound(int32_t value, uint8_t count) const
+  {
+    uint8_t low = 0;
+    uint8_t high = count;
+    while (low < high)
+    {
+      uint8_t mid = (low + high) / 2;
+      if (_sorted[mid] < value)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    return low;
+  }
+};
+
+// =======================
+// TuyaEmaFilter
+// =======================
+
+// Exponential moving average with alpha = 1 / 2^Shift, kept with 8 extra
+// fractional bits so small steps are not lost to truncation.
+template <uint8_t Shift>
+class TuyaEmaFilter
+{
+  static_assert(Shift > 0 && Shift < 16, "EMA shift out of range");
+
+public:
+  int32_t update(int32_t sample)
+  {
+    int32_t scaled = sample * 256;
+    if (!_primed)
+    {
+      _state = scaled;
+      _primed = true;
+    }
+    else
+    {
+      _state += (scaled - _state) / (1 << Shift);
+    }
+    return (_state + (_state >= 0 ? 128 : -128)) / 256;
+  }
+
+private:
+  int32_t _state = 0;
+  bool _primed = false;
+};
+
+// =======================
+// TuyaKalmanFilter
+// =======================
+
+// Scalar Kalman filter for a constant signal. ProcessNoise (q) and
+// MeasurementNoise (r) are variances in squared DP units; the gain is
+// computed in Q16.
+template <uint32_t ProcessNoise, uint32_t MeasurementNoise>
+class TuyaKalmanFilter
+{
+  static_assert(MeasurementNoise > 0, "measurement noise must be positive");
+
+public:
+  int32_t update(int32_t sample)
+  {
+    if (!_primed)
+    {
+      _estimate = static_cast<int64_t>(sample) * 256;
+      _error = MeasurementNoise;
+      _primed = true;
+      return sample;
+    }
+
+    uint32_t predicted = _error + ProcessNoise;
+    uint32_t gain = (static_cast<uint64_t>(predicted) << 16) / (predicted + MeasurementNoise);
+    int64_t innovation = static_cast<int64_t>(sample) * 256 - _estimate;
+    _estimate += (innovation * gain) / 65536;
+    _error = (static_cast<uint64_t>(predicted) * (65536 - gain)) >> 16;
+    if (_error == 0)
+      _error = 1;
+
+    return (_estimate + (_estimate >= 0 ? 128 : -128)) / 256;
+  }
+
+private:
+  int64_t _estimate = 0;
+  uint32_t _error = 0;
+  bool _primed = false;
+};
+
+// =======================
+// TuyaFilterChain
+// =======================
+
+// Runs First, then Second, e.g. a median to drop spikes followed by an EMA.
+template <typename First, typename Second>
+class TuyaFilterChain
+{
+public:
+  int32_t update(int32_t sample) { return _second.update(_first.update(sample)); }
+
+private:
+  First _first;
+  Second _second;
+};
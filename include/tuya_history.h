@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+#include <tuya_water_quality.h>
+
+// =======================
+// Structs
+// =======================
+
+// One reading in fixed point: temperature x10, pH x100, TDS x1. The
+// timestamp unit is up to the caller (seconds keep the deltas smallest).
+struct TuyaHistorySample
+{
+  uint32_t timestamp;
+  int32_t temperature;
+  int32_t ph;
+  int32_t tds;
+};
+
+TuyaHistorySample tuyaHistorySample(uint32_t timestamp, const TuyaWaterQualitySensorData &data);
+
+// Aggregate of the samples whose timestamps fall in [start, start + bucket)
+struct TuyaHistoryBucket
+{
+  uint32_t start;
+  uint32_t count;
+  TuyaHistorySample min;
+  TuyaHistorySample max;
+  TuyaHistorySample mean;
+};
+
+class TuyaHistorySink
+{
+public:
+  virtual ~TuyaHistorySink() {}
+  virtual void write(const TuyaHistorySample &sample) = 0;
+};
+
+// =======================
+// TuyaHistoryDownsampler Class
+// =======================
+
+// Time-bucketed min/max/mean in one pass: only the open bucket is kept.
+// Closed buckets are handed to the sink as their mean (timestamp = bucket
+// start), or as min, mean and max when the envelope is enabled.
+class TuyaHistoryDownsampler
+{
+public:
+  TuyaHistoryDownsampler(TuyaHistorySink &sink, uint32_t bucketLength, bool envelope = false);
+
+  void add(const TuyaHistorySample &sample);
+  void finish();
+
+  const TuyaHistoryBucket &getLastBucket() const;
+
+private:
+  TuyaHistorySink &_sink;
+  uint32_t _bucketLength;
+  bool _envelope;
+  bool _open;
+  TuyaHistoryBucket _bucket;
+  TuyaHistoryBucket _lastBucket;
+  int64_t _sum[3];
+
+  void close();
+};
+
+// =======================
+// TuyaHistoryEncoder Class
+// =======================
+
+// Packs samples into a byte stream: a 3-byte header ("TH", version), then
+// per sample the zigzag varint of the timestamp delta-of-delta followed by
+// zigzag varint deltas of temperature, pH and TDS. The first sample is
+// encoded against zero. A steady series costs 4 bytes per sample.
+class TuyaHistoryEncoder : public TuyaHistorySink
+{
+public:
+  explicit TuyaHistoryEncoder(Print &out);
+
+  void write(const TuyaHistorySample &sample) override;
+
+  uint32_t getSampleCount() const;
+  uint32_t getByteCount() const;
+
+private:
+  Print &_out;
+  bool _headerWritten;
+  TuyaHistorySample _previous;
+  int64_t _previousDelta;
+  uint32_t _samples;
+  uint32_t _bytes;
+
+  void writeVarint(uint64_t value);
+  void writeSigned(int64_t value);
+};
+
+// =======================
+// TuyaHistoryDecoder Class
+// =======================
+
+class TuyaHistoryDecoder
+{
+public:
+  TuyaHistoryDecoder(const uint8_t *data, size_t length);
+
+  bool next(TuyaHistorySample &sample);
+
+private:
+  const uint8_t *_data;
+  size_t _length;
+  size_t _position;
+  bool _valid;
+  TuyaHistorySample _previous;
+  int64_t _previousDelta;
+
+  bool readVarint(uint64_t &value);
+  bool readSigned(int64_t &value);
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Stream.h>
+#include <tuya.h>
+
+// =======================
+// Structs
+// =======================
+
+struct TuyaMcuSimulatorConfig
+{
+  const char *productInfo;   // JSON with product_id, version and operation_mode
+  uint32_t reportIntervalMs; // 0 disables unsolicited 0x07 reports
+  uint16_t reportBurst;      // reports sent per interval, cycling through the DPs
+  uint16_t corruptPerMille;  // chance of flipping each outgoing byte
+  uint16_t maxChunk;         // bytes released per poll(), 0 = no splitting
+  uint32_t latencyMs;        // delay before a frame becomes readable
+  uint32_t seed;
+};
+
+struct TuyaMcuSimulatorStats
+{
+  uint32_t framesReceived;
+  uint32_t framesSent;
+  uint32_t checksumErrors;
+  uint32_t bytesCorrupted;
+  uint32_t bytesDropped;
+  uint32_t otaBytes;
+};
+
+// =======================
+// TuyaLoopbackStream Class
+// =======================
+
+// One end of an in-memory serial link: reads from one ring, writes to the other.
+class TuyaLoopbackStream : public Stream
+{
+public:
+  TuyaLoopbackStream(TuyaRxBuffer &rx, TuyaRxBuffer &tx);
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int availableForWrite() override;
+
+private:
+  TuyaRxBuffer &_rx;
+  TuyaRxBuffer &_tx;
+  int _peeked;
+};
+
+// =======================
+// TuyaMcuSimulator Class
+// =======================
+
+// Plays the MCU side of the protocol: answers heartbeats, product info,
+// working mode, DP queries and commands, acknowledges OTA packets and sends
+// asynchronous reports. It either owns an in-memory link (pass
+// getModuleStream() to Tuya::begin) or talks to any Stream, e.g. a
+// pseudo-terminal.
+class TuyaMcuSimulator
+{
+public:
+  TuyaMcuSimulator();
+
+  void begin(const TuyaMcuSimulatorConfig &config);
+  void begin(Stream *link, const TuyaMcuSimulatorConfig &config);
+  void poll();
+
+  // Data points
+  bool addDp(uint8_t dp, int32_t value, uint16_t noise);
+  bool setDp(uint8_t dp, int32_t value);
+  void reportDp(uint8_t dp);
+
+  // State
+  Stream &getModuleStream();
+  const TuyaMcuSimulatorStats &getStats() const;
+
+private:
+  struct Dp
+  {
+    uint8_t id;
+    int32_t value;
+    uint16_t noise;
+  };
+
+  struct PendingFrame
+  {
+    uint32_t readyMs;
+    uint16_t length;
+  };
+
+  // In-memory link
+  uint8_t _moduleToMcuStorage[TUYA_SIMULATOR_PIPE_SIZE];
+  uint8_t _mcuToModuleStorage[TUYA_SIMULATOR_PIPE_SIZE];
+  TuyaRxBuffer _moduleToMcu;
+  TuyaRxBuffer _mcuToModule;
+  TuyaLoopbackStream _mcuStream;
+  TuyaLoopbackStream _moduleStream;
+
+  // Outgoing frames held back for latency and splitting
+  uint8_t _pendingStorage[TUYA_SIMULATOR_PIPE_SIZE];
+  TuyaRxBuffer _pending;
+  PendingFrame _pendingFrames[16];
+  uint8_t _pendingHead;
+  uint8_t _pendingCount;
+
+  // Receive
+  uint8_t _rxData[64];
+  uint8_t _rxCommand;
+  uint16_t _rxLength;
+  uint16_t _rxIndex;
+  uint8_t _rxChecksum;
+
+  Stream *_link;
+  TuyaMcuSimulatorConfig _config;
+  TuyaMcuSimulatorStats _stats;
+  Dp _dps[TUYA_SIMULATOR_MAX_DPS];
+  uint8_t _dpCount;
+  uint8_t _nextReportDp;
+  uint32_t _lastReportMs;
+  uint32_t _random;
+  bool _heartbeatAnswered;
+
+  void receive();
+  void parseByte(uint8_t byte);
+  void handleFrame();
+  void sendFrame(TuyaCommand command, const uint8_t *data, uint16_t length);
+  void sendReports();
+  void release();
+  Dp *findDp(uint8_t dp);
+  uint32_t nextRandom();
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Stream.h>
+
+// =======================
+// Enums
+// =======================
+
+enum class TuyaOtaState : uint8_t
+{
+  Idle = 0,
+  Starting,
+  Transferring,
+  Finishing,
+  Done,
+  Failed,
+};
+
+enum class TuyaOtaError : uint8_t
+{
+  None = 0,
+  Aborted,        // abort() was called
+  Timeout,        // The MCU stopped answering after maxRetries resends
+  Rejected,       // The MCU replied to StartOta with an unknown packet size
+  SourceTooSmall, // The source cannot hold one packet of the size the MCU picked
+  SourceStalled,  // The source had no data for timeoutMs
+  SourceRead,     // The source returned fewer bytes than ready() promised
+};
+
+// =======================
+// OTA Sources
+// =======================
+
+// Random-access view of a firmware image. The engine asks for the bytes of a
+// packet with ready() before it starts writing the frame, then pulls them in
+// small blocks with read(). Offsets below the last release() are never
+// requested again. capacity() is the largest packet ready() can ever hold.
+// The MCU picks the packet size (256, 512 or 1024 bytes), and a smaller source
+// fails the transfer right after StartOta.
+class TuyaOtaSource
+{
+public:
+  virtual ~TuyaOtaSource() {}
+
+  virtual uint32_t size() const = 0;
+  virtual uint32_t capacity() const;
+  virtual bool ready(uint32_t offset, uint16_t length);
+  virtual uint16_t read(uint32_t offset, uint8_t *buffer, uint16_t length) = 0;
+  virtual void release(uint32_t offset);
+};
+
+// Image held in RAM.
+class TuyaOtaMemorySource : public TuyaOtaSource
+{
+public:
+  TuyaOtaMemorySource(const uint8_t *data, uint32_t size);
+
+  uint32_t size() const override;
+  uint16_t read(uint32_t offset, uint8_t *buffer, uint16_t length) override;
+
+private:
+  const uint8_t *_data;
+  uint32_t _size;
+};
+
+// Image read sequentially from a Stream (file, network client, ...). Bytes
+// that are sent but not yet acknowledged are kept in a caller-provided buffer
+// so they can be resent; it must hold at least one packet (1024 bytes covers
+// every packet size the MCU can pick).
+class TuyaOtaStreamSource : public TuyaOtaSource
+{
+public:
+  TuyaOtaStreamSource(Stream &stream, uint32_t size, uint8_t *buffer, uint16_t bufferSize);
+
+  uint32_t size() const override;
+  uint32_t capacity() const override;
+  bool ready(uint32_t offset, uint16_t length) override;
+  uint16_t read(uint32_t offset, uint8_t *buffer, uint16_t length) override;
+  void release(uint32_t offset) override;
+
+private:
+  Stream &_stream;
+  uint32_t _size;
+  uint8_t *_buffer;
+  uint16_t _bufferSize;
+  uint32_t _base;
+  uint16_t _filled;
+};
+
+// =======================
+// TuyaOta Class
+// =======================
+
+// Streams a firmware image to the MCU with StartOta (0x0A) and
+// TransmitOtaData (0x0B). Packets are written straight from the source to the
+// serial port, so RAM usage does not depend on the image or packet size.
+// One packet is in flight at a time: the MCU's acknowledgement carries no
+// offset, so with more in flight a lost packet followed by the ack of a later
+// one would be counted as delivered. A stalled MCU or source fails the
+// transfer after timeoutMs (and maxRetries resends for the MCU).
+class TuyaOta
+{
+public:
+  TuyaOta();
+
+  bool begin(Stream *serial, TuyaOtaSource &source, uint32_t timeoutMs, uint8_t maxRetries);
+  void poll();
+  void abort();
+
+  // Replies from the MCU
+  void handleStartOta(const uint8_t *data, uint16_t length);
+  void handleTransmitOtaData();
+
+  // State
+  bool isActive() const;
+  TuyaOtaState getState() const;
+  TuyaOtaError getError() const;
+  uint32_t getSize() const;
+  uint32_t getAcknowledged() const;
+  uint16_t getPacketSize() const;
+  // CRC-32 (IEEE 802.3) of the image bytes sent so far
+  uint32_t getCrc32() const;
+  uint32_t getResends() const;
+
+private:
+  Stream *_serial;
+  TuyaOtaSource *_source;
+  TuyaOtaState _state;
+  TuyaOtaError _error;
+  uint32_t _size;
+  uint16_t _packetSize;
+  uint32_t _timeoutMs;
+  uint8_t _maxRetries;
+  uint8_t _retries;
+  uint32_t _resends;
+  uint32_t _ackedOffset;
+  uint32_t _sentOffset;
+  uint32_t _crcOffset;
+  uint32_t _crc32;
+  uint32_t _lastProgressMs;
+
+  void sendStartOta();
+  bool sendPacket(uint32_t offset, uint16_t length);
+  void retry();
+  void fail(TuyaOtaError error);
+  bool isPacketInFlight() const;
+  uint16_t packetLength(uint32_t offset) const;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Stream.h>
+#include <atomic>
+
+#if defined(ESP8266) || defined(ESP32)
+#define TUYA_ISR_ATTR IRAM_ATTR
+#else
+#define TUYA_ISR_ATTR
+#endif
+
+// =======================
+// TuyaRxBuffer Class
+// =======================
+
+// Wait-free single-producer/single-consumer byte ring. The producer is a UART
+// interrupt or timer callback on the device, or a reader thread on a host; the
+// consumer is Tuya::loop(). Indexing uses a mask, so a capacity that is not a
+// power of two is rounded down to one; getCapacity() reports the bytes
+// actually used.
+class TuyaRxBuffer
+{
+public:
+  TuyaRxBuffer(uint8_t *storage, size_t capacity);
+
+  // Producer side
+  bool push(uint8_t byte);
+  size_t push(const uint8_t *data, size_t length);
+  size_t pump(Stream &stream);
+
+  // Consumer side
+  size_t available() const;
+  size_t read(uint8_t *data, size_t length);
+
+  // Statistics
+  size_t getCapacity() const;
+  uint32_t getOverruns() const;
+  size_t getHighWatermark() const;
+  void resetStatistics();
+
+private:
+  uint8_t *_storage;
+  size_t _capacity;
+  size_t _mask;
+  std::atomic<uint32_t> _head;
+  std::atomic<uint32_t> _tail;
+  std::atomic<uint32_t> _overruns;
+  std::atomic<uint32_t> _highWatermark;
+
+  void updateHighWatermark(uint32_t used);
+};
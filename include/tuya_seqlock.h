@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// =======================
+// TuyaSeqlock Class
+// =======================
+
+// Single-writer, multi-reader publication of a trivially copyable value.
+// The writer fills the slot readers are not looking at, then flips `_latest`,
+// so a reader only retries if two publications complete while it copies.
+// Readers never block the writer and the writer never waits for readers,
+// which makes read() safe from timer callbacks and other threads.
+// Only loads and stores are used, no read-modify-write atomics.
+template <typename T>
+class TuyaSeqlock
+{
+public:
+  TuyaSeqlock() : _latest(0), _generation(0)
+  {
+    _sequence[0].store(0, std::memory_order_relaxed);
+    _sequence[1].store(0, std::memory_order_relaxed);
+    _slots[0] = T{};
+    _slots[1] = T{};
+  }
+
+  // Writer side; must not be called concurrently with itself
+  void publish(const T &value)
+  {
+    uint8_t slot = _latest.load(std::memory_order_relaxed) ^ 1;
+    uint32_t sequence = _sequence[slot].load(std::memory_order_relaxed);
+
+    _sequence[slot].store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _slots[slot] = value;
+    _sequence[slot].store(sequence + 2, std::memory_order_release);
+
+    _latest.store(slot, std::memory_order_release);
+    _generation.store(_generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Reader side
+  void read(T &value) const
+  {
+    while (true)
+    {
+      uint8_t slot = _latest.load(std::memory_order_acquire);
+      uint32_t before = _sequence[slot].load(std::memory_order_acquire);
+      if (before & 1)
+        continue;
+
+      value = _slots[slot];
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_sequence[slot].load(std::memory_order_relaxed) == before)
+        return;
+    }
+  }
+
+  // Number of publications so far; cheap to poll for changes
+  uint32_t getGeneration() const
+  {
+    return _generation.load(std::memory_order_acquire);
+  }
+
+private:
+  T _slots[2];
+  std::atomic<uint32_t> _sequence[2];
+  std::atomic<uint8_t> _latest;
+  std::atomic<uint32_t> _generation;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <tuya_config.h>
+
+// =======================
+// TuyaStateStore Class
+// =======================
+
+// Storage for the warm-start record (see Tuya::setStateStore). The payload
+// is framed with a magic, a format version, its length and a CRC-32, so a
+// record written by another firmware layout or torn by a reset mid-write is
+// rejected on load. Implementations only move whole 32-bit words.
+class TuyaStateStore
+{
+public:
+  // Whole record, header included
+  static constexpr uint16_t capacityWords = 64;
+  static constexpr uint16_t headerWords = 3;
+  static constexpr uint16_t payloadCapacity = (capacityWords - headerWords) * 4;
+
+  virtual ~TuyaStateStore() {}
+
+  bool writeRecord(const uint8_t *payload, uint16_t length);
+  // Payload length, or -1 when there is no valid record
+  int16_t readRecord(uint8_t *payload, uint16_t capacity);
+  bool invalidate();
+
+protected:
+  virtual bool load(uint32_t *words, uint16_t count) = 0;
+  virtual bool save(const uint32_t *words, uint16_t count) = 0;
+};
+
+// =======================
+// TuyaMemoryStateStore Class
+// =======================
+
+// Over caller-provided words, e.g. a `.noinit` section that survives a
+// software reset, or plain RAM on the host
+class TuyaMemoryStateStore : public TuyaStateStore
+{
+public:
+  TuyaMemoryStateStore(uint32_t *words, uint16_t count);
+
+protected:
+  bool load(uint32_t *words, uint16_t count) override;
+  bool save(const uint32_t *words, uint16_t count) override;
+
+private:
+  uint32_t *_words;
+  uint16_t _count;
+};
+
+#if defined(ARDUINO_ARCH_ESP8266)
+// =======================
+// TuyaRtcStateStore Class
+// =======================
+
+// ESP8266 RTC user memory (128 words): survives resets and deep sleep, not
+// power loss, and has no write wear. `offset` is in words.
+class TuyaRtcStateStore : public TuyaStateStore
+{
+public:
+  explicit TuyaRtcStateStore(uint8_t offset = 0);
+
+protected:
+  bool load(uint32_t *words, uint16_t count) override;
+  bool save(const uint32_t *words, uint16_t count) override;
+
+private:
+  uint8_t _offset;
+};
+#endif
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <Arduino.h>
+
+// =======================
+// Enums
+// =======================
+
+enum class TuyaTxPriority : uint8_t
+{
+  Low = 0, // Status queries
+  Normal,  // Commands and handshake queries
+  High,    // Heartbeats and network status
+};
+
+// =======================
+// Structs
+// =======================
+
+struct TuyaTxStats
+{
+  uint32_t sent;
+  uint32_t merged;  // Superseded by a later frame with the same key
+  uint32_t dropped; // Queue full and no lower priority frame to evict
+  uint8_t queued;
+  uint8_t highWatermark;
+};
+
+// =======================
+// TuyaTxQueue Class
+// =======================
+
+// Outgoing frames waiting for loop(), highest priority first and FIFO within
+// a priority. A frame replaces a queued one with the same key in place: a
+// write to the same DP, or any other frame with the same command (repeated
+// queries, heartbeats, status replies). When full, a frame evicts the newest
+// queued frame of lower priority; DP writes are never evicted, because the
+// caller was told they were accepted. The last free slot is kept for high
+// priority frames, so a queue full of DP writes still takes a heartbeat.
+// Sending is paced by a token bucket in bytes; high priority frames may
+// borrow up to one burst so heartbeats are never starved by commands.
+template <typename Frame, uint8_t Capacity>
+class TuyaTxQueue
+{
+public:
+  static_assert(Capacity > 0, "TuyaTxQueue capacity must not be zero");
+
+  TuyaTxQueue() : _count(0), _bytesPerSecond(0), _burst(0), _tokens(0), _milliTokens(0), _lastRefillMs(0), _stats{}
+  {
+  }
+
+  // 0 bytes per second disables the limiter. The burst is raised to at least
+  // one full frame, or large frames could never be sent.
+  void setRate(uint16_t bytesPerSecond, uint16_t burstBytes)
+  {
+    _bytesPerSecond = bytesPerSecond;
+    _burst = burstBytes < maxFrameBytes ? maxFrameBytes : burstBytes;
+    _tokens = _burst;
+    _milliTokens = 0;
+    _lastRefillMs = millis();
+  }
+
+  bool push(const Frame &frame, TuyaTxPriority priority)
+  {
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      if (sameKey(_slots[i].frame, frame))
+      {
+        _slots[i].frame = frame;
+        if (priority > _slots[i].priority)
+          _slots[i].priority = priority;
+        _stats.merged++;
+        return true;
+      }
+    }
+
+    // Below high priority the reserved slot counts as taken
+    uint8_t limit = priority == TuyaTxPriority::High || Capacity == 1 ? Capacity : Capacity - 1;
+    if (_count >= limit)
+    {
+      // Evict the newest of the lowest priority frames that are not DP
+      // writes, if it ranks below
+      int16_t victim = -1;
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        if (_slots[i].frame.command == sendCommand)
+          continue;
+        if (victim < 0 || _slots[i].priority <= _slots[victim].priority)
+          victim = i;
+      }
+      _stats.dropped++;
+      if (victim < 0 || _slots[victim].priority >= priority)
+        return false;
+      remove(victim);
+    }
+
+    _slots[_count].frame = frame;
+    _slots[_count].priority = priority;
+    _count++;
+    _stats.queued = _count;
+    if (_count > _stats.highWatermark)
+      _stats.highWatermark = _count;
+    return true;
+  }
+
+  // Next frame the limiter allows at nowMs, if any
+  bool pop(uint32_t nowMs, Frame &frame)
+  {
+    if (_count == 0)
+      return false;
+
+    uint8_t next = 0;
+    for (uint8_t i = 1; i < _count; i++)
+    {
+      if (_slots[i].priority > _slots[next].priority)
+        next = i;
+    }
+
+    if (_bytesPerSecond != 0)
+    {
+      refill(nowMs);
+      int32_t size = frameBytes(_slots[next].frame);
+      int32_t floor = _slots[next].priority == TuyaTxPriority::High ? -_burst : 0;
+      if (_tokens - size < floor)
+        return false;
+      _tokens -= size;
+    }
+
+    frame = _slots[next].frame;
+    remove(next);
+    _stats.sent++;
+    return true;
+  }
+
+  void clear()
+  {
+    _count = 0;
+    _stats.queued = 0;
+  }
+
+  uint8_t getCount() const
+  {
+    return _count;
+  }
+
+  const TuyaTxStats &getStats() const
+  {
+    return _stats;
+  }
+
+private:
+  // TuyaCommand::SendCommand; its payload starts with the DP id
+  static constexpr uint8_t sendCommand = 0x06;
+  static constexpr int32_t maxFrameBytes = sizeof(Frame::data) + 7;
+
+  struct Slot
+  {
+    Frame frame;
+    TuyaTxPriority priority;
+  };
+
+  Slot _slots[Capacity];
+  uint8_t _count;
+  uint16_t _bytesPerSecond;
+  int32_t _burst;
+  int32_t _tokens;
+  uint16_t _milliTokens;
+  uint32_t _lastRefillMs;
+  TuyaTxStats _stats;
+
+  static uint16_t dataLength(const Frame &frame)
+  {
+    return (frame.length[0] << 8) | frame.length[1];
+  }
+
+  static int32_t frameBytes(const Frame &frame)
+  {
+    return dataLength(frame) + 7;
+  }
+
+  static bool sameKey(const Frame &a, const Frame &b)
+  {
+    if (a.command != b.command)
+      return false;
+    if (a.command != sendCommand)
+      return true;
+    return dataLength(a) > 0 && dataLength(b) > 0 && a.data[0] == b.data[0];
+  }
+
+  void remove(uint8_t index)
+  {
+    for (uint8_t i = index; i + 1 < _count; i++)
+    {
+      _slots[i] = _slots[i + 1];
+    }
+    _count--;
+    _stats.queued = _count;
+  }
+
+  void refill(uint32_t nowMs)
+  {
+    uint32_t elapsed = nowMs - _lastRefillMs;
+    uint32_t fullMs = static_cast<uint32_t>(_burst) * 2000 / _bytesPerSecond;
+    _lastRefillMs = nowMs;
+    if (elapsed >= fullMs)
+    {
+      _tokens = _burst;
+      _milliTokens = 0;
+      return;
+    }
+
+    // Whole bytes are credited; the fraction carries over in _milliTokens so
+    // the long-run rate is exact for any bytesPerSecond
+    uint32_t milliTokens = elapsed * _bytesPerSecond + _milliTokens;
+    _tokens += milliTokens / 1000;
+    _milliTokens = milliTokens % 1000;
+    if (_tokens >= _burst)
+    {
+      _tokens = _burst;
+      _milliTokens = 0;
+    }
+  }
+};
@@ -3,6 +3,18 @@
 #include <Arduino.h>
 #include <Stream.h>
 #include <tuya.h>
+#include <tuya_filter.h>
+#include <tuya_seqlock.h>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define TUYA_HAS_COROUTINES 1
+#endif
+#endif
+
+class TuyaWaterQuality;
 
 // =======================
 // Enums
@@ -21,6 +33,15 @@ enum class TuyaWaterQualityDp : uint8_t
   LowTDSThreshold = 0x71,
 };
 
+enum class TuyaRequestState : uint8_t
+{
+  Invalid = 0,
+  Pending,
+  Done,
+  TimedOut,
+  Failed,
+};
+
 // =======================
 // Structs
 // =======================
@@ -30,6 +51,7 @@ struct TuyaSensorValue
   double value;
   double maxThreshold;
   double minThreshold;
+  double filtered;
 };
 
 struct TuyaWaterQualitySensorData
@@ -39,6 +61,18 @@ struct TuyaWaterQualitySensorData
   TuyaSensorValue tds;
 };
 
+// Consistent copy of the sensor data as of the last decoded frame; every DP
+// of a report is applied before it is published. A snapshot
+// restored from a state store is flagged `restored`: its readings predate
+// the reset and timestampMs is when they were restored, not measured.
+struct TuyaWaterQualitySnapshot
+{
+  TuyaWaterQualitySensorData data;
+  uint32_t timestampMs;
+  uint32_t generation;
+  bool restored;
+};
+
 struct TuyaWaterQualityInfo
 {
   String productId;
@@ -46,6 +80,58 @@ struct TuyaWaterQualityInfo
   uint16_t operationMode;
 };
 
+// =======================
+// TuyaRequest Class
+// =======================
+
+// Handle to a command whose result arrives later as a ReportStatusAsync DP.
+// A query resolves on any report of its DP; a setter only when the MCU
+// reports the requested value (after fixed-point rounding), so a value the
+// MCU clamps times out. Only reports decoded after the request was made
+// resolve it. Resolution and deadlines are observed by loop().
+// Results stay readable until TUYA_MAX_PENDING_REQUESTS newer requests have
+// reused the slot, after which the state reads Invalid. When every slot is
+// pending, the command is not sent and the handle is Invalid.
+class TuyaRequest
+{
+public:
+  TuyaRequest();
+
+  TuyaRequestState getState() const;
+  bool isPending() const;
+  double getValue() const;
+
+#if TUYA_HAS_COROUTINES
+  // `co_await request` suspends until the request resolves and yields its state
+  bool await_ready() const;
+  void await_suspend(std::coroutine_handle<> waiter) const;
+  TuyaRequestState await_resume() const;
+#endif
+
+private:
+  friend class TuyaWaterQuality;
+  TuyaRequest(TuyaWaterQuality *owner, uint8_t slot, uint32_t generation);
+
+  TuyaWaterQuality *_owner;
+  uint8_t _slot;
+  uint32_t _generation;
+};
+
+#if TUYA_HAS_COROUTINES
+// Fire-and-forget coroutine type for sequences of awaited requests driven by loop()
+struct TuyaTask
+{
+  struct promise_type
+  {
+    TuyaTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+#endif
+
 // =======================
 // TuyaWaterQuality Class
 // =======================
@@ -57,12 +143,22 @@ public:
 
   // Query
   bool queryStatus();
+  TuyaRequest queryStatusAsync(TuyaWaterQualityDp dp, uint32_t timeoutMs = 3000);
 
   // Getters
   double getTemperature() const;
   double getPh() const;
   int32_t getTds() const;
 
+  // Safe from timer callbacks, async handlers or other threads; the getters
+  // above are only consistent when called from the loop() context
+  void getSnapshot(TuyaWaterQualitySnapshot &snapshot) const;
+  uint32_t getSnapshotGeneration() const;
+
+  double getFilteredTemperature() const;
+  double getFilteredPh() const;
+  int32_t getFilteredTds() const;
+
   double getMaxTemperature() const;
   double getMinTemperature() const;
   double getMaxPh() const;
@@ -78,18 +174,61 @@ public:
   bool setMaxTds(int32_t value);
   bool setMinTds(int32_t value);
 
+  // Setters resolving when the MCU reports the new threshold back
+  TuyaRequest setMaxTemperatureAsync(double value, uint32_t timeoutMs = 3000);
+  TuyaRequest setMinTemperatureAsync(double value, uint32_t timeoutMs = 3000);
+  TuyaRequest setMaxPhAsync(double value, uint32_t timeoutMs = 3000);
+  TuyaRequest setMinPhAsync(double value, uint32_t timeoutMs = 3000);
+  TuyaRequest setMaxTdsAsync(int32_t value, uint32_t timeoutMs = 3000);
+  TuyaRequest setMinTdsAsync(int32_t value, uint32_t timeoutMs = 3000);
+
   // Event
   void onSensorData(void (*callback)(TuyaWaterQualitySensorData &sensorData));
 
 protected:
   bool decodeReportStatusAsync(TuyaFrame &frame) override;
+  bool decodeDp(uint8_t dp, TuyaDataType dataType, const uint8_t *value, uint16_t valueLength) override;
+  void poll() override;
+#if TUYA_ENABLE_WARM_START
+  uint16_t saveState(uint8_t *data, uint16_t capacity) const override;
+  bool restoreState(const uint8_t *data, uint16_t length) override;
+#endif
 
 private:
+  friend class TuyaRequest;
+
+  struct PendingRequest
+  {
+    TuyaWaterQualityDp dp;
+    TuyaRequestState state;
+    uint32_t generation;
+    uint32_t reportSequence;
+    bool matchValue;
+    int32_t rawValue;
+    uint32_t deadlineMs;
+    double value;
+#if TUYA_HAS_COROUTINES
+    std::coroutine_handle<> waiter;
+#endif
+  };
+
   TuyaWaterQualitySensorData _sensorData;
+  TuyaSeqlock<TuyaWaterQualitySnapshot> _snapshot;
+  PendingRequest _requests[TUYA_MAX_PENDING_REQUESTS];
+  TUYA_TEMPERATURE_FILTER _temperatureFilter;
+  TUYA_PH_FILTER _phFilter;
+  TUYA_TDS_FILTER _tdsFilter;
+  uint8_t _nextRequest = 0;
+  uint32_t _reportSequence = 0;
+  bool _sensorDataChanged = false;
   void (*_onSensorDataCallback)(TuyaWaterQualitySensorData &sensorData) = nullptr;
 
-  uint32_t decodeSensorRawValue(const uint8_t *data) const;
+  uint32_t decodeSensorRawValue(const uint8_t *value) const;
   bool setThreshold(TuyaWaterQualityDp dp, double value);
   bool setThreshold(TuyaWaterQualityDp dp, int32_t value);
+  TuyaRequest setThresholdAsync(TuyaWaterQualityDp dp, int32_t value, uint32_t timeoutMs);
+  int32_t toFixedPoint(TuyaWaterQualityDp dp, double value) const;
+  PendingRequest *reserveRequest(TuyaWaterQualityDp dp, uint32_t timeoutMs, TuyaRequest &handle);
+  void resolveRequests(TuyaWaterQualityDp dp, int32_t rawValue, double value);
   bool buildSensorDataPayload(uint8_t (&buffer)[8], TuyaWaterQualityDp dp, int32_t value) const;
 };
\ No newline at end of file
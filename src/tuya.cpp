@@ -1,9 +1,24 @@
 #include <ArduinoJson.h>
 #include "tuya.h"
 
+#if TUYA_ENABLE_WARM_START
+namespace
+{
+  // Persisted product info: id and version NUL-padded, operation mode big-endian
+  constexpr uint16_t STATE_PRODUCT_ID_SIZE = 32;
+  constexpr uint16_t STATE_VERSION_SIZE = 16;
+  constexpr uint16_t STATE_PRODUCT_INFO_SIZE = STATE_PRODUCT_ID_SIZE + STATE_VERSION_SIZE + 2;
+}
+#endif
+
 Tuya::Tuya()
     : _serial(nullptr),
       _debugStream(nullptr),
+      _rxBuffer(nullptr),
+      _rxIndex(0),
+      _rxChecksum(0),
+      _rxChunkPos(0),
+      _rxChunkLen(0),
       _moduleInfo{
           .productInfo = {
               .productId = "",
@@ -14,14 +29,28 @@ Tuya::Tuya()
           .heartbeatsReceived = false,
           .productInfoReceived = false,
           .workingModeReceived = false,
-          .initialized = false},
+          .initialized = false,
+          .restored = false},
       _delayMs(250), _heartbeatIntervalMs(1000), _lastHeartbeatMs(0), _debugEnabled(false), _resetWiFiPairModeCallback(nullptr)
 {
+  _txQueue.setRate(TUYA_TX_RATE_BYTES_PER_SECOND, TUYA_TX_BURST_BYTES);
 }
 
 void Tuya::begin(Stream *serial)
+{
+  begin(serial, nullptr);
+}
+
+void Tuya::begin(Stream *serial, TuyaRxBuffer *rxBuffer)
 {
   _serial = serial;
+  _rxBuffer = rxBuffer;
+  _rxIndex = 0;
+  _rxChunkPos = 0;
+  _rxChunkLen = 0;
+#if TUYA_ENABLE_WARM_START
+  restoreStateRecord();
+#endif
 }
 
 void Tuya::loop()
@@ -38,25 +67,55 @@ void Tuya::loop()
     _lastHeartbeatMs = millis();
   }
 
-  if (_moduleInfo.heartbeatsReceived && !_moduleInfo.productInfoReceived)
+  // A restored state is re-verified in the background, with the handshake
+  // queries paced by the heartbeat interval instead of sent every loop()
+  bool queryDue = !_moduleInfo.restored || millis() - _lastVerifyMs >= _heartbeatIntervalMs;
+  if (queryDue && _moduleInfo.heartbeatsReceived && !_moduleInfo.productInfoReceived)
   {
     queryProductInfo();
+    _lastVerifyMs = millis();
   }
 
-  if (_moduleInfo.heartbeatsReceived && !_moduleInfo.workingModeReceived)
+  if (queryDue && _moduleInfo.heartbeatsReceived && !_moduleInfo.workingModeReceived)
   {
     queryWorkingMode();
+    _lastVerifyMs = millis();
   }
 
-  TuyaFrame frame;
-  if (receiveMessage(frame) == TuyaError::None)
+  TuyaError error;
+  while ((error = receiveMessage(_rxFrame)) != TuyaError::NoData)
   {
-    decodeFrame(frame);
+    if (error == TuyaError::None)
+    {
+      decodeFrame(_rxFrame);
+    }
+    else
+    {
+      TuyaEvent event = createEvent(TuyaEventType::LinkError);
+      event.error = error;
+      publishEvent(event);
+    }
   }
 
-  _moduleInfo.initialized = _moduleInfo.heartbeatsReceived &&
-                            _moduleInfo.productInfoReceived &&
-                            _moduleInfo.workingModeReceived;
+#if TUYA_ENABLE_OTA
+  _ota.poll();
+#endif
+  poll();
+  flushTxQueue();
+
+  bool verified = _moduleInfo.heartbeatsReceived &&
+                  _moduleInfo.productInfoReceived &&
+                  _moduleInfo.workingModeReceived;
+#if TUYA_ENABLE_WARM_START
+  // A completed handshake is saved at once, later changes at most every interval
+  bool completed = verified && !_moduleInfo.initialized;
+  if (_stateStore != nullptr && _stateDirty && (verified || _moduleInfo.restored) &&
+      (completed || millis() - _lastStateSaveMs >= _stateSaveIntervalMs))
+  {
+    saveStateRecord();
+  }
+#endif
+  _moduleInfo.initialized = verified;
 
   delay(_delayMs);
 }
@@ -72,11 +131,29 @@ void Tuya::setDelay(uint32_t delayMs)
   _delayMs = delayMs;
 }
 
+#if TUYA_ENABLE_WARM_START
+void Tuya::setStateStore(TuyaStateStore *store, uint32_t saveIntervalMs)
+{
+  _stateStore = store;
+  _stateSaveIntervalMs = saveIntervalMs;
+}
+#endif
+
 bool Tuya::isInitialized() const
+{
+  return _moduleInfo.initialized || _moduleInfo.restored;
+}
+
+bool Tuya::isVerified() const
 {
   return _moduleInfo.initialized;
 }
 
+bool Tuya::isRestored() const
+{
+  return _moduleInfo.restored;
+}
+
 TuyaNetworkStatus Tuya::getNetworkStatus() const
 {
   return _moduleInfo.networkStatus;
@@ -87,80 +164,190 @@ TuyaProductInfo Tuya::getProductInfo() const
   return _moduleInfo.productInfo;
 }
 
+void Tuya::setTxRate(uint16_t bytesPerSecond, uint16_t burstBytes)
+{
+  _txQueue.setRate(bytesPerSecond, burstBytes);
+}
+
+const TuyaTxStats &Tuya::getTxStats() const
+{
+  return _txQueue.getStats();
+}
+
+#if TUYA_ENABLE_OTA
+bool Tuya::startOta(TuyaOtaSource &source, uint32_t timeoutMs, uint8_t maxRetries)
+{
+  if (!_moduleInfo.initialized)
+  {
+    return false;
+  }
+  return _ota.begin(_serial, source, timeoutMs, maxRetries);
+}
+
+void Tuya::abortOta()
+{
+  _ota.abort();
+}
+
+const TuyaOta &Tuya::getOta() const
+{
+  return _ota;
+}
+#endif
+
 void Tuya::onResetWiFiPairMode(void (*callback)())
 {
   _resetWiFiPairModeCallback = callback;
 }
 
+int8_t Tuya::subscribe(uint8_t eventMask, TuyaEventHandler handler, void *context, const TuyaDpFilter &filter)
+{
+#if TUYA_ENABLE_EVENTS
+  return _eventBus.subscribe(eventMask, handler, context, filter);
+#else
+  (void)eventMask;
+  (void)handler;
+  (void)context;
+  (void)filter;
+  return -1;
+#endif
+}
+
+bool Tuya::unsubscribe(int8_t id)
+{
+#if TUYA_ENABLE_EVENTS
+  return _eventBus.unsubscribe(id);
+#else
+  (void)id;
+  return false;
+#endif
+}
+
 TuyaError Tuya::receiveMessage(TuyaFrame &frame)
 {
-  while (_serial->available())
+  // Frames may arrive split across calls, so the parser keeps its position in
+  // _rxIndex and only reports a frame once its checksum byte is in.
+  while (_rxChunkPos < _rxChunkLen || fillReceiveChunk())
   {
-    frame.header[0] = _serial->read();
-    if (frame.header[0] == 0x55)
+    TuyaError error = parseByte(frame, _rxChunk[_rxChunkPos++]);
+    if (error != TuyaError::NoData)
     {
-      frame.header[1] = _serial->read();
-      if (frame.header[1] == 0xAA)
-      {
-        frame.version = _serial->read();
-        frame.command = _serial->read();
-        frame.length[0] = _serial->read();
-        frame.length[1] = _serial->read();
-        uint16_t dataLength = (frame.length[0] << 8) | frame.length[1];
-        if (dataLength > sizeof(frame.data))
-        {
-          _serial->flush();
-          return TuyaError::Overflow;
-        }
-        if (dataLength > 0)
-        {
-          _serial->readBytes(frame.data, dataLength);
-        }
-        frame.checksum = _serial->read();
-        if (!validateChecksum(frame))
-        {
-          _serial->flush();
-          return TuyaError::Checksum;
-        }
-        _serial->flush();
-        return TuyaError::None;
-      }
+      return error;
     }
   }
   return TuyaError::NoData;
 }
 
-bool Tuya::validateChecksum(const TuyaFrame &frame) const
+TuyaError Tuya::parseByte(TuyaFrame &frame, uint8_t byte)
 {
-  uint16_t sum = frame.header[0] + frame.header[1] + frame.version + frame.command + frame.length[0] + frame.length[1];
-  uint16_t len = (frame.length[0] << 8) | frame.length[1];
-  for (uint16_t i = 0; i < len; i++)
+  // The checksum is summed as bytes arrive so the payload is walked only once
+  switch (_rxIndex)
   {
-    sum += frame.data[i];
+  case 0:
+    frame.header[0] = byte;
+    if (byte == 0x55)
+      _rxIndex++;
+    return TuyaError::NoData;
+  case 1:
+    frame.header[1] = byte;
+    if (byte == 0xAA)
+    {
+      _rxChecksum = 0x55 + 0xAA;
+      _rxIndex++;
+    }
+    else if (byte != 0x55)
+      _rxIndex = 0;
+    return TuyaError::NoData;
+  case 2:
+    frame.version = byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return TuyaError::NoData;
+  case 3:
+    frame.command = byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return TuyaError::NoData;
+  case 4:
+    frame.length[0] = byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return TuyaError::NoData;
+  case 5:
+    frame.length[1] = byte;
+    _rxChecksum += byte;
+    if (static_cast<uint16_t>((frame.length[0] << 8) | frame.length[1]) > sizeof(frame.data))
+    {
+      _rxIndex = 0;
+      return TuyaError::Overflow;
+    }
+    _rxIndex++;
+    return TuyaError::NoData;
+  default:
+    break;
+  }
+
+  uint16_t dataLength = (frame.length[0] << 8) | frame.length[1];
+  uint16_t dataIndex = _rxIndex - 6;
+  if (dataIndex < dataLength)
+  {
+    frame.data[dataIndex] = byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return TuyaError::NoData;
   }
-  return (sum % 256) == frame.checksum;
+
+  frame.checksum = byte;
+  _rxIndex = 0;
+  return _rxChecksum == byte ? TuyaError::None : TuyaError::Checksum;
 }
 
-uint8_t Tuya::calculateChecksum(const TuyaFrame &frame) const
+bool Tuya::fillReceiveChunk()
 {
-  uint16_t sum = frame.header[0] + frame.header[1] + frame.version + frame.command + frame.length[0] + frame.length[1];
+  _rxChunkPos = 0;
+  _rxChunkLen = 0;
+
+  if (_rxBuffer != nullptr)
+  {
+    _rxChunkLen = _rxBuffer->read(_rxChunk, sizeof(_rxChunk));
+    return _rxChunkLen > 0;
+  }
+
+  int available = _serial->available();
+  if (available <= 0)
+  {
+    return false;
+  }
+  size_t wanted = static_cast<size_t>(available) < sizeof(_rxChunk) ? available : sizeof(_rxChunk);
+  _rxChunkLen = _serial->readBytes(_rxChunk, wanted);
+  return _rxChunkLen > 0;
+}
+
+uint8_t Tuya::calculateChecksum(const TuyaTxFrame &frame) const
+{
+  uint8_t sum = frame.header[0] + frame.header[1] + frame.version + frame.command + frame.length[0] + frame.length[1];
   uint16_t len = (frame.length[0] << 8) | frame.length[1];
   for (uint16_t i = 0; i < len; i++)
   {
     sum += frame.data[i];
   }
-  return (sum % 256);
+  return sum;
 }
 
-TuyaFrame Tuya::createFrame(TuyaDeviceType deviceType, TuyaCommand command, uint8_t *data, uint16_t dataLength) const
+TuyaTxFrame Tuya::createFrame(TuyaDeviceType deviceType, TuyaCommand command, uint8_t *data, uint16_t dataLength) const
 {
-  TuyaFrame frame{};
+  TuyaTxFrame frame{};
   frame.header[0] = 0x55;
   frame.header[1] = 0xAA;
   frame.version = static_cast<uint8_t>(deviceType);
   frame.command = static_cast<uint8_t>(command);
   frame.length[0] = (dataLength >> 8) & 0xFF;
   frame.length[1] = dataLength & 0xFF;
+  if (dataLength > sizeof(frame.data))
+  {
+    // Left without payload or checksum; sendFrame() refuses it
+    return frame;
+  }
   if (dataLength > 0 && data != nullptr)
   {
     memcpy(frame.data, data, dataLength);
@@ -169,16 +356,18 @@ TuyaFrame Tuya::createFrame(TuyaDeviceType deviceType, TuyaCommand command, uint
   return frame;
 }
 
-TuyaFrame Tuya::createFrame(TuyaDeviceType deviceType, TuyaCommand command) const
+TuyaTxFrame Tuya::createFrame(TuyaDeviceType deviceType, TuyaCommand command) const
 {
   return createFrame(deviceType, command, nullptr, 0);
 }
 
-bool Tuya::sendFrame(const TuyaFrame &frame) const
+bool Tuya::sendFrame(const TuyaTxFrame &frame) const
 {
   if (!_serial)
     return false;
   uint16_t len = (frame.length[0] << 8) | frame.length[1];
+  if (len > sizeof(frame.data))
+    return false;
   _serial->write(frame.header[0]);
   _serial->write(frame.header[1]);
   _serial->write(frame.version);
@@ -194,6 +383,117 @@ bool Tuya::sendFrame(const TuyaFrame &frame) const
   return true;
 }
 
+bool Tuya::queueFrame(const TuyaTxFrame &frame, TuyaTxPriority priority)
+{
+  uint16_t len = (frame.length[0] << 8) | frame.length[1];
+  if (!_serial || len > sizeof(frame.data))
+    return false;
+  return _txQueue.push(frame, priority);
+}
+
+void Tuya::flushTxQueue()
+{
+  TuyaTxFrame frame;
+  while (_txQueue.pop(millis(), frame))
+  {
+    sendFrame(frame);
+  }
+}
+
+TuyaEvent Tuya::createEvent(TuyaEventType type) const
+{
+  TuyaEvent event{};
+  event.type = type;
+  event.dataType = TuyaDataType::Raw;
+  event.networkStatus = _moduleInfo.networkStatus;
+  event.error = TuyaError::None;
+  return event;
+}
+
+void Tuya::publishEvent(const TuyaEvent &event) const
+{
+#if TUYA_ENABLE_EVENTS
+  _eventBus.publish(event);
+#else
+  (void)event;
+#endif
+}
+
+#if TUYA_ENABLE_WARM_START
+uint16_t Tuya::saveState(uint8_t *, uint16_t) const
+{
+  return 0;
+}
+
+bool Tuya::restoreState(const uint8_t *, uint16_t)
+{
+  return true;
+}
+#endif
+
+void Tuya::markStateDirty()
+{
+#if TUYA_ENABLE_WARM_START
+  _stateDirty = true;
+#endif
+}
+
+#if TUYA_ENABLE_WARM_START
+void Tuya::restoreStateRecord()
+{
+  _moduleInfo.restored = false;
+  if (_stateStore == nullptr)
+  {
+    return;
+  }
+
+  uint8_t payload[TuyaStateStore::payloadCapacity];
+  int16_t length = _stateStore->readRecord(payload, sizeof(payload));
+  if (length < STATE_PRODUCT_INFO_SIZE ||
+      !restoreState(payload + STATE_PRODUCT_INFO_SIZE, length - STATE_PRODUCT_INFO_SIZE))
+  {
+    return;
+  }
+
+  char productId[STATE_PRODUCT_ID_SIZE + 1] = {};
+  char version[STATE_VERSION_SIZE + 1] = {};
+  memcpy(productId, payload, STATE_PRODUCT_ID_SIZE);
+  memcpy(version, payload + STATE_PRODUCT_ID_SIZE, STATE_VERSION_SIZE);
+  _moduleInfo.productInfo.productId = productId;
+  _moduleInfo.productInfo.version = version;
+  _moduleInfo.productInfo.operationMode =
+      (payload[STATE_PRODUCT_INFO_SIZE - 2] << 8) | payload[STATE_PRODUCT_INFO_SIZE - 1];
+  _moduleInfo.restored = true;
+
+  if (_debugEnabled && _debugStream)
+  {
+    _debugStream->println("Restored state, verifying in background");
+  }
+}
+
+void Tuya::saveStateRecord()
+{
+  _stateDirty = false;
+  _lastStateSaveMs = millis();
+
+  // A truncated product id would be served as valid after the next reset
+  const TuyaProductInfo &info = _moduleInfo.productInfo;
+  if (info.productId.length() > STATE_PRODUCT_ID_SIZE || info.version.length() > STATE_VERSION_SIZE)
+  {
+    return;
+  }
+
+  uint8_t payload[TuyaStateStore::payloadCapacity] = {};
+  memcpy(payload, info.productId.c_str(), info.productId.length());
+  memcpy(payload + STATE_PRODUCT_ID_SIZE, info.version.c_str(), info.version.length());
+  payload[STATE_PRODUCT_INFO_SIZE - 2] = info.operationMode >> 8;
+  payload[STATE_PRODUCT_INFO_SIZE - 1] = info.operationMode & 0xFF;
+  uint16_t length = STATE_PRODUCT_INFO_SIZE +
+                    saveState(payload + STATE_PRODUCT_INFO_SIZE, sizeof(payload) - STATE_PRODUCT_INFO_SIZE);
+  _stateStore->writeRecord(payload, length);
+}
+#endif
+
 void Tuya::decodeFrame(TuyaFrame &frame)
 {
   printFrame(frame);
@@ -221,6 +521,14 @@ void Tuya::decodeFrame(TuyaFrame &frame)
   case TuyaCommand::ResetWiFiPairMode:
     handleResetWiFiPairMode(frame);
     break;
+#if TUYA_ENABLE_OTA
+  case TuyaCommand::StartOta:
+    handleStartOta(frame);
+    break;
+  case TuyaCommand::TransmitOtaData:
+    handleTransmitOtaData(frame);
+    break;
+#endif
   default:
     handleUnknownCommand(frame);
     break;
@@ -260,9 +568,11 @@ void Tuya::setNetworkStatus(TuyaNetworkStatus status)
 {
   _moduleInfo.networkStatus = status;
   reportNetworkStatus();
+
+  publishEvent(createEvent(TuyaEventType::NetworkStatus));
 }
 
-void Tuya::reportNetworkStatus() const
+void Tuya::reportNetworkStatus()
 {
   if (_debugEnabled && _debugStream)
   {
@@ -270,35 +580,33 @@ void Tuya::reportNetworkStatus() const
   }
 
   uint8_t data[1] = {static_cast<uint8_t>(_moduleInfo.networkStatus)};
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::ReportNetworkStatus, data, sizeof(data));
-  sendFrame(frame);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::ReportNetworkStatus, data);
+  queueFrame(frame, TuyaTxPriority::High);
 }
 
-void Tuya::sendNetworkStatus() const
+void Tuya::sendNetworkStatus()
 {
   uint8_t data[1] = {static_cast<uint8_t>(_moduleInfo.networkStatus)};
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::GetCurrentNetworkStatus, data, sizeof(data));
-  sendFrame(frame);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::GetCurrentNetworkStatus, data);
+  queueFrame(frame, TuyaTxPriority::High);
 }
 
-void Tuya::sendHeartbeats() const
+void Tuya::sendHeartbeats()
 {
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::Heartbeats);
-  sendFrame(frame);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::Heartbeats);
+  queueFrame(frame, TuyaTxPriority::High);
 }
 
-void Tuya::queryProductInfo() const
+void Tuya::queryProductInfo()
 {
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::QueryProductInfo);
-  sendFrame(frame);
-  delay(_delayMs);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::QueryProductInfo);
+  queueFrame(frame);
 }
 
-void Tuya::queryWorkingMode() const
+void Tuya::queryWorkingMode()
 {
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::QueryWorkingMode);
-  sendFrame(frame);
-  delay(_delayMs);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::QueryWorkingMode);
+  queueFrame(frame);
 }
 
 bool Tuya::decodeHeartbeats(TuyaFrame &)
@@ -309,10 +617,9 @@ bool Tuya::decodeHeartbeats(TuyaFrame &)
 bool Tuya::decodeProductInfo(TuyaFrame &frame)
 {
   uint16_t length = (frame.length[0] << 8) | frame.length[1];
-  String productInfoStr = dataToString(frame.data, length);
 
   JsonDocument json;
-  if (deserializeJson(json, productInfoStr))
+  if (deserializeJson(json, reinterpret_cast<const char *>(frame.data), length))
   {
     return false;
   }
@@ -329,20 +636,40 @@ bool Tuya::decodeQueryWorkingMode(TuyaFrame &)
   return true;
 }
 
-bool Tuya::decodeReportStatusAsync(TuyaFrame &)
+bool Tuya::decodeReportStatusAsync(TuyaFrame &frame)
+{
+  // Each DP is encoded as id (1), type (1), length (2), value (length)
+  uint16_t length = (frame.length[0] << 8) | frame.length[1];
+  uint16_t offset = 0;
+  bool decoded = true;
+  while (offset + 4 <= length)
+  {
+    uint16_t valueLength = (frame.data[offset + 2] << 8) | frame.data[offset + 3];
+    if (offset + 4 + valueLength > length)
+    {
+      return false;
+    }
+
+    decoded &= decodeDp(frame.data[offset], static_cast<TuyaDataType>(frame.data[offset + 1]),
+                        frame.data + offset + 4, valueLength);
+    offset += 4 + valueLength;
+  }
+  return decoded && offset == length;
+}
+
+bool Tuya::decodeDp(uint8_t dp, TuyaDataType dataType, const uint8_t *value, uint16_t valueLength)
 {
+  TuyaEvent event = createEvent(TuyaEventType::DpUpdate);
+  event.dp = dp;
+  event.dataType = dataType;
+  event.value = value;
+  event.valueLength = valueLength;
+  publishEvent(event);
   return true;
 }
 
-String Tuya::dataToString(uint8_t *data, uint16_t length) const
+void Tuya::poll()
 {
-  String result;
-  result.reserve(length);
-  for (uint16_t i = 0; i < length; i++)
-  {
-    result += static_cast<char>(data[i]);
-  }
-  return result;
 }
 
 void Tuya::handleHeartbeats(TuyaFrame &frame)
@@ -361,6 +688,10 @@ void Tuya::handleQueryProductInfo(TuyaFrame &frame)
     _debugStream->println("Received query product info");
   }
   _moduleInfo.productInfoReceived = decodeProductInfo(frame);
+  if (_moduleInfo.productInfoReceived)
+  {
+    markStateDirty();
+  }
 }
 
 void Tuya::handleQueryWorkingMode(TuyaFrame &frame)
@@ -410,7 +741,30 @@ void Tuya::handleResetWiFiPairMode(TuyaFrame &)
   {
     _resetWiFiPairModeCallback();
   }
+
+  publishEvent(createEvent(TuyaEventType::ResetWiFiPairMode));
+}
+
+#if TUYA_ENABLE_OTA
+void Tuya::handleStartOta(TuyaFrame &frame)
+{
+  if (_debugEnabled && _debugStream)
+  {
+    _debugStream->println("Received start OTA");
+  }
+  uint16_t length = (frame.length[0] << 8) | frame.length[1];
+  _ota.handleStartOta(frame.data, length);
+}
+
+void Tuya::handleTransmitOtaData(TuyaFrame &)
+{
+  if (_debugEnabled && _debugStream)
+  {
+    _debugStream->println("Received transmit OTA data");
+  }
+  _ota.handleTransmitOtaData();
 }
+#endif
 
 void Tuya::handleUnknownCommand(TuyaFrame &)
 {
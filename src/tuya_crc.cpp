@@ -0,0 +1,14 @@
+#include "tuya_crc.h"
+
+uint32_t tuyaCrc32Update(uint32_t crc, const uint8_t *data, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
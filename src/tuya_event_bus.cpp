@@ -0,0 +1,99 @@
+#include "tuya_event_bus.h"
+#include "tuya.h"
+
+// =======================
+// TuyaDpFilter
+// =======================
+
+TuyaDpFilter TuyaDpFilter::all()
+{
+  TuyaDpFilter filter;
+  memset(filter.bits, 0xFF, sizeof(filter.bits));
+  return filter;
+}
+
+TuyaDpFilter TuyaDpFilter::none()
+{
+  TuyaDpFilter filter;
+  memset(filter.bits, 0x00, sizeof(filter.bits));
+  return filter;
+}
+
+TuyaDpFilter &TuyaDpFilter::add(uint8_t dp)
+{
+  bits[dp >> 5] |= 1UL << (dp & 0x1F);
+  return *this;
+}
+
+bool TuyaDpFilter::matches(uint8_t dp) const
+{
+  return (bits[dp >> 5] >> (dp & 0x1F)) & 1;
+}
+
+// =======================
+// TuyaEventBus
+// =======================
+
+TuyaEventBus::TuyaEventBus()
+{
+  for (Subscriber &subscriber : _subscribers)
+  {
+    subscriber.handler = nullptr;
+    subscriber.context = nullptr;
+    subscriber.eventMask = 0;
+  }
+}
+
+int8_t TuyaEventBus::subscribe(uint8_t eventMask, TuyaEventHandler handler, void *context, const TuyaDpFilter &filter)
+{
+  if (handler == nullptr)
+    return -1;
+
+  for (int8_t i = 0; i < TUYA_EVENT_MAX_SUBSCRIBERS; i++)
+  {
+    Subscriber &subscriber = _subscribers[i];
+    if (subscriber.handler == nullptr)
+    {
+      subscriber.handler = handler;
+      subscriber.context = context;
+      subscriber.filter = filter;
+      subscriber.eventMask = eventMask;
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool TuyaEventBus::unsubscribe(int8_t id)
+{
+  if (id < 0 || id >= TUYA_EVENT_MAX_SUBSCRIBERS || _subscribers[id].handler == nullptr)
+    return false;
+  _subscribers[id].handler = nullptr;
+  return true;
+}
+
+void TuyaEventBus::publish(const TuyaEvent &event) const
+{
+  uint8_t mask = tuyaEventMask(event.type);
+  bool hasDp = event.type == TuyaEventType::DpUpdate || event.type == TuyaEventType::ThresholdChange;
+
+  for (const Subscriber &subscriber : _subscribers)
+  {
+    if (subscriber.handler == nullptr || !(subscriber.eventMask & mask))
+      continue;
+    if (hasDp && !subscriber.filter.matches(event.dp))
+      continue;
+    subscriber.handler(subscriber.context, event);
+  }
+}
+
+uint8_t TuyaEventBus::getSubscriberCount() const
+{
+  uint8_t count = 0;
+  for (const Subscriber &subscriber : _subscribers)
+  {
+    if (subscriber.handler != nullptr)
+      count++;
+  }
+  return count;
+}
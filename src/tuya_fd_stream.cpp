@@ -0,0 +1,229 @@
+#include "tuya_fd_stream.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+  speed_t baudToSpeed(uint32_t baud)
+  {
+    switch (baud)
+    {
+    case 1200:
+      return B1200;
+    case 2400:
+      return B2400;
+    case 4800:
+      return B4800;
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    case 38400:
+      return B38400;
+    case 57600:
+      return B57600;
+    case 115200:
+      return B115200;
+    default:
+      return B0;
+    }
+  }
+}
+
+TuyaFdStream::TuyaFdStream() : _fd(-1), _head(0), _tail(0), _writeDrops(0), _writeTimeoutMs(100)
+{
+}
+
+TuyaFdStream::~TuyaFdStream()
+{
+  close();
+}
+
+bool TuyaFdStream::open(const char *path, uint32_t baud)
+{
+  close();
+  _fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (_fd < 0)
+    return false;
+  if (!configureRaw(baud))
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool TuyaFdStream::openPty(char *slaveName, size_t slaveNameLength)
+{
+  close();
+  _fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (_fd < 0)
+    return false;
+  if (grantpt(_fd) != 0 || unlockpt(_fd) != 0 || ptsname_r(_fd, slaveName, slaveNameLength) != 0 ||
+      !configureRaw(0))
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool TuyaFdStream::attach(int fd)
+{
+  close();
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+    return false;
+  _fd = fd;
+  return true;
+}
+
+void TuyaFdStream::close()
+{
+  if (_fd >= 0)
+  {
+    ::close(_fd);
+    _fd = -1;
+  }
+  _head = 0;
+  _tail = 0;
+}
+
+int TuyaFdStream::getFd() const
+{
+  return _fd;
+}
+
+size_t TuyaFdStream::fill()
+{
+  if (_fd < 0)
+    return 0;
+
+  if (_head == _tail)
+  {
+    _head = 0;
+    _tail = 0;
+  }
+
+  size_t total = 0;
+  while (_tail < sizeof(_buffer))
+  {
+    ssize_t count = ::read(_fd, _buffer + _tail, sizeof(_buffer) - _tail);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      break;
+    _tail += count;
+    total += count;
+  }
+  return total;
+}
+
+uint32_t TuyaFdStream::getWriteDrops() const
+{
+  return _writeDrops;
+}
+
+void TuyaFdStream::setWriteTimeout(uint32_t timeoutMs)
+{
+  _writeTimeoutMs = timeoutMs;
+}
+
+int TuyaFdStream::available()
+{
+  if (_head == _tail)
+    fill();
+  return _tail - _head;
+}
+
+int TuyaFdStream::read()
+{
+  if (available() == 0)
+    return -1;
+  return _buffer[_head++];
+}
+
+int TuyaFdStream::peek()
+{
+  if (available() == 0)
+    return -1;
+  return _buffer[_head];
+}
+
+size_t TuyaFdStream::write(uint8_t byte)
+{
+  return write(&byte, 1);
+}
+
+size_t TuyaFdStream::write(const uint8_t *buffer, size_t size)
+{
+  if (_fd < 0)
+    return 0;
+
+  // A frame cut short desynchronises the MCU, so a full kernel buffer is
+  // waited out, bounded by the write timeout to keep the event loop alive
+  size_t written = 0;
+  uint32_t start = millis();
+  while (written < size)
+  {
+    ssize_t count = ::write(_fd, buffer + written, size - written);
+    if (count > 0)
+    {
+      written += count;
+      continue;
+    }
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+      break;
+
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= _writeTimeoutMs)
+      break;
+    struct pollfd descriptor = {_fd, POLLOUT, 0};
+    int ready = poll(&descriptor, 1, static_cast<int>(_writeTimeoutMs - elapsed));
+    if (ready == 0 || (ready < 0 && errno != EINTR))
+      break;
+  }
+  _writeDrops += size - written;
+  return written;
+}
+
+void TuyaFdStream::flush()
+{
+  // Draining the UART would block the event loop; bytes are already queued
+}
+
+bool TuyaFdStream::configureRaw(uint32_t baud)
+{
+  struct termios options;
+  if (tcgetattr(_fd, &options) != 0)
+    return false;
+
+  cfmakeraw(&options);
+  options.c_cflag |= CLOCAL | CREAD;
+  options.c_cflag &= ~(CSTOPB | CRTSCTS);
+  options.c_cc[VMIN] = 0;
+  options.c_cc[VTIME] = 0;
+
+  if (baud != 0)
+  {
+    speed_t speed = baudToSpeed(baud);
+    if (speed == B0)
+      return false;
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
+  }
+
+  return tcsetattr(_fd, TCSANOW, &options) == 0 && tcflush(_fd, TCIOFLUSH) == 0;
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "tuya_history.h"
+
+namespace
+{
+  constexpr uint8_t HISTORY_MAGIC_0 = 'T';
+  constexpr uint8_t HISTORY_MAGIC_1 = 'H';
+  constexpr uint8_t HISTORY_VERSION = 1;
+
+  int32_t toFixed(double value, int32_t scale)
+  {
+    double scaled = value * scale;
+    return static_cast<int32_t>(scaled >= 0 ? scaled + 0.5 : scaled - 0.5);
+  }
+
+  int32_t *channels(TuyaHistorySample &sample, uint8_t index)
+  {
+    return index == 0 ? &sample.temperature : index == 1 ? &sample.ph : &sample.tds;
+  }
+
+  int32_t channel(const TuyaHistorySample &sample, uint8_t index)
+  {
+    return index == 0 ? sample.temperature : index == 1 ? sample.ph : sample.tds;
+  }
+}
+
+TuyaHistorySample tuyaHistorySample(uint32_t timestamp, const TuyaWaterQualitySensorData &data)
+{
+  return {
+      timestamp,
+      toFixed(data.temperature.value, 10),
+      toFixed(data.ph.value, 100),
+      toFixed(data.tds.value, 1),
+  };
+}
+
+// =======================
+// TuyaHistoryDownsampler
+// =======================
+
+TuyaHistoryDownsampler::TuyaHistoryDownsampler(TuyaHistorySink &sink, uint32_t bucketLength, bool envelope)
+    : _sink(sink), _bucketLength(bucketLength > 0 ? bucketLength : 1), _envelope(envelope), _open(false), _bucket{},
+      _lastBucket{}, _sum{0, 0, 0}
+{
+}
+
+void TuyaHistoryDownsampler::add(const TuyaHistorySample &sample)
+{
+  uint32_t start = sample.timestamp - sample.timestamp % _bucketLength;
+  if (_open && start != _bucket.start)
+  {
+    close();
+  }
+
+  if (!_open)
+  {
+    _open = true;
+    _bucket.start = start;
+    _bucket.count = 0;
+    _bucket.min = sample;
+    _bucket.max = sample;
+    _sum[0] = _sum[1] = _sum[2] = 0;
+  }
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t value = channel(sample, i);
+    if (value < channel(_bucket.min, i))
+      *channels(_bucket.min, i) = value;
+    if (value > channel(_bucket.max, i))
+      *channels(_bucket.max, i) = value;
+    _sum[i] += value;
+  }
+  _bucket.count++;
+}
+
+void TuyaHistoryDownsampler::finish()
+{
+  if (_open)
+  {
+    close();
+  }
+}
+
+const TuyaHistoryBucket &TuyaHistoryDownsampler::getLastBucket() const
+{
+  return _lastBucket;
+}
+
+void TuyaHistoryDownsampler::close()
+{
+  _bucket.mean.timestamp = _bucket.start;
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    *channels(_bucket.mean, i) = static_cast<int32_t>(_sum[i] / _bucket.count);
+  }
+  _bucket.min.timestamp = _bucket.start;
+  _bucket.max.timestamp = _bucket.start;
+  _lastBucket = _bucket;
+  _open = false;
+
+  if (_envelope)
+  {
+    // Same timestamp three times encodes as zero delta-of-delta
+    _sink.write(_bucket.min);
+    _sink.write(_bucket.mean);
+    _sink.write(_bucket.max);
+  }
+  else
+  {
+    _sink.write(_bucket.mean);
+  }
+}
+
+// =======================
+// TuyaHistoryEncoder
+// =======================
+
+TuyaHistoryEncoder::TuyaHistoryEncoder(Print &out)
+    : _out(out), _headerWritten(false), _previous{}, _previousDelta(0), _samples(0), _bytes(0)
+{
+}
+
+void TuyaHistoryEncoder::write(const TuyaHistorySample &sample)
+{
+  if (!_headerWritten)
+  {
+    uint8_t header[3] = {HISTORY_MAGIC_0, HISTORY_MAGIC_1, HISTORY_VERSION};
+    _bytes += _out.write(header, sizeof(header));
+    _headerWritten = true;
+  }
+
+  int64_t delta = static_cast<int64_t>(sample.timestamp) - _previous.timestamp;
+  writeSigned(delta - _previousDelta);
+  writeSigned(static_cast<int64_t>(sample.temperature) - _previous.temperature);
+  writeSigned(static_cast<int64_t>(sample.ph) - _previous.ph);
+  writeSigned(static_cast<int64_t>(sample.tds) - _previous.tds);
+
+  _previousDelta = _samples == 0 ? 0 : delta;
+  _previous = sample;
+  _samples++;
+}
+
+uint32_t TuyaHistoryEncoder::getSampleCount() const
+{
+  return _samples;
+}
+
+uint32_t TuyaHistoryEncoder::getByteCount() const
+{
+  return _bytes;
+}
+
+void TuyaHistoryEncoder::writeVarint(uint64_t value)
+{
+  uint8_t buffer[10];
+  uint8_t length = 0;
+  do
+  {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    buffer[length++] = value ? byte | 0x80 : byte;
+  } while (value);
+  _bytes += _out.write(buffer, length);
+}
+
+void TuyaHistoryEncoder::writeSigned(int64_t value)
+{
+  writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+// =======================
+// TuyaHistoryDecoder
+// =======================
+
+TuyaHistoryDecoder::TuyaHistoryDecoder(const uint8_t *data, size_t length)
+    : _data(data), _length(length), _position(3), _valid(false), _previous{}, _previousDelta(0)
+{
+  _valid = length >= 3 && data[0] == HISTORY_MAGIC_0 && data[1] == HISTORY_MAGIC_1 && data[2] == HISTORY_VERSION;
+}
+
+bool TuyaHistoryDecoder::next(TuyaHistorySample &sample)
+{
+  if (!_valid || _position >= _length)
+    return false;
+
+  bool first = _position == 3;
+  int64_t deltaOfDelta, temperature, ph, tds;
+  if (!readSigned(deltaOfDelta) || !readSigned(temperature) || !readSigned(ph) || !readSigned(tds))
+  {
+    _valid = false;
+    return false;
+  }
+
+  int64_t delta = _previousDelta + deltaOfDelta;
+  sample.timestamp = static_cast<uint32_t>(_previous.timestamp + delta);
+  sample.temperature = static_cast<int32_t>(_previous.temperature + temperature);
+  sample.ph = static_cast<int32_t>(_previous.ph + ph);
+  sample.tds = static_cast<int32_t>(_previous.tds + tds);
+
+  _previousDelta = first ? 0 : delta;
+  _previous = sample;
+  return true;
+}
+
+bool TuyaHistoryDecoder::readVarint(uint64_t &value)
+{
+  value = 0;
+  for (uint8_t shift = 0; shift < 64; shift += 7)
+  {
+    if (_position >= _length)
+      return false;
+    uint8_t byte = _data[_position++];
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+bool TuyaHistoryDecoder::readSigned(int64_t &value)
+{
+  uint64_t raw;
+  if (!readVarint(raw))
+    return false;
+  value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+  return true;
+}
@@ -0,0 +1,394 @@
+#include "tuya_mcu_simulator.h"
+
+// =======================
+// TuyaLoopbackStream
+// =======================
+
+TuyaLoopbackStream::TuyaLoopbackStream(TuyaRxBuffer &rx, TuyaRxBuffer &tx)
+    : _rx(rx), _tx(tx), _peeked(-1)
+{
+}
+
+int TuyaLoopbackStream::available()
+{
+  return _rx.available() + (_peeked >= 0 ? 1 : 0);
+}
+
+int TuyaLoopbackStream::read()
+{
+  if (_peeked >= 0)
+  {
+    int byte = _peeked;
+    _peeked = -1;
+    return byte;
+  }
+  uint8_t byte;
+  return _rx.read(&byte, 1) == 1 ? byte : -1;
+}
+
+int TuyaLoopbackStream::peek()
+{
+  if (_peeked < 0)
+  {
+    uint8_t byte;
+    if (_rx.read(&byte, 1) == 1)
+      _peeked = byte;
+  }
+  return _peeked;
+}
+
+size_t TuyaLoopbackStream::write(uint8_t byte)
+{
+  return _tx.push(byte) ? 1 : 0;
+}
+
+size_t TuyaLoopbackStream::write(const uint8_t *buffer, size_t size)
+{
+  return _tx.push(buffer, size);
+}
+
+int TuyaLoopbackStream::availableForWrite()
+{
+  return _tx.getCapacity() - _tx.available();
+}
+
+// =======================
+// TuyaMcuSimulator
+// =======================
+
+TuyaMcuSimulator::TuyaMcuSimulator()
+    : _moduleToMcu(_moduleToMcuStorage, sizeof(_moduleToMcuStorage)),
+      _mcuToModule(_mcuToModuleStorage, sizeof(_mcuToModuleStorage)),
+      _mcuStream(_moduleToMcu, _mcuToModule),
+      _moduleStream(_mcuToModule, _moduleToMcu),
+      _pending(_pendingStorage, sizeof(_pendingStorage)),
+      _pendingHead(0), _pendingCount(0),
+      _rxCommand(0), _rxLength(0), _rxIndex(0), _rxChecksum(0),
+      _link(nullptr), _config{}, _stats{}, _dpCount(0), _nextReportDp(0), _lastReportMs(0), _random(1),
+      _heartbeatAnswered(false)
+{
+}
+
+void TuyaMcuSimulator::begin(const TuyaMcuSimulatorConfig &config)
+{
+  begin(&_mcuStream, config);
+}
+
+void TuyaMcuSimulator::begin(Stream *link, const TuyaMcuSimulatorConfig &config)
+{
+  _link = link;
+  _config = config;
+  _stats = {};
+  _random = config.seed != 0 ? config.seed : 1;
+  _heartbeatAnswered = false;
+  _lastReportMs = millis();
+}
+
+void TuyaMcuSimulator::poll()
+{
+  if (_link == nullptr)
+    return;
+
+  receive();
+  sendReports();
+  release();
+}
+
+bool TuyaMcuSimulator::addDp(uint8_t dp, int32_t value, uint16_t noise)
+{
+  if (findDp(dp) != nullptr || _dpCount >= TUYA_SIMULATOR_MAX_DPS)
+    return false;
+  _dps[_dpCount++] = {dp, value, noise};
+  return true;
+}
+
+bool TuyaMcuSimulator::setDp(uint8_t dp, int32_t value)
+{
+  Dp *entry = findDp(dp);
+  if (entry == nullptr)
+    return false;
+  entry->value = value;
+  return true;
+}
+
+void TuyaMcuSimulator::reportDp(uint8_t dp)
+{
+  Dp *entry = findDp(dp);
+  if (entry == nullptr)
+    return;
+
+  int32_t value = entry->value;
+  if (entry->noise > 0)
+  {
+    value += static_cast<int32_t>(nextRandom() % (2 * entry->noise + 1)) - entry->noise;
+  }
+
+  uint8_t data[8] = {
+      entry->id,
+      static_cast<uint8_t>(TuyaDataType::Value),
+      0x00, 0x04,
+      static_cast<uint8_t>(value >> 24),
+      static_cast<uint8_t>(value >> 16),
+      static_cast<uint8_t>(value >> 8),
+      static_cast<uint8_t>(value)};
+  sendFrame(TuyaCommand::ReportStatusAsync, data, sizeof(data));
+}
+
+Stream &TuyaMcuSimulator::getModuleStream()
+{
+  return _moduleStream;
+}
+
+const TuyaMcuSimulatorStats &TuyaMcuSimulator::getStats() const
+{
+  return _stats;
+}
+
+void TuyaMcuSimulator::receive()
+{
+  uint8_t chunk[32];
+  int available;
+  while ((available = _link->available()) > 0)
+  {
+    size_t wanted = static_cast<size_t>(available) < sizeof(chunk) ? available : sizeof(chunk);
+    size_t count = _link->readBytes(chunk, wanted);
+    if (count == 0)
+      break;
+    for (size_t i = 0; i < count; i++)
+    {
+      parseByte(chunk[i]);
+    }
+  }
+}
+
+void TuyaMcuSimulator::parseByte(uint8_t byte)
+{
+  switch (_rxIndex)
+  {
+  case 0:
+    if (byte == 0x55)
+      _rxIndex++;
+    return;
+  case 1:
+    if (byte == 0xAA)
+    {
+      _rxChecksum = 0x55 + 0xAA;
+      _rxIndex++;
+    }
+    else if (byte != 0x55)
+      _rxIndex = 0;
+    return;
+  case 2:
+    _rxChecksum += byte;
+    _rxIndex++;
+    return;
+  case 3:
+    _rxCommand = byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return;
+  case 4:
+    _rxLength = byte << 8;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return;
+  case 5:
+    _rxLength |= byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return;
+  default:
+    break;
+  }
+
+  // Payloads longer than _rxData (OTA packets) are checksummed but not kept
+  uint16_t dataIndex = _rxIndex - 6;
+  if (dataIndex < _rxLength)
+  {
+    if (dataIndex < sizeof(_rxData))
+      _rxData[dataIndex] = byte;
+    _rxChecksum += byte;
+    _rxIndex++;
+    return;
+  }
+
+  _rxIndex = 0;
+  if (_rxChecksum != byte)
+  {
+    _stats.checksumErrors++;
+    return;
+  }
+  _stats.framesReceived++;
+  handleFrame();
+}
+
+void TuyaMcuSimulator::handleFrame()
+{
+  switch (static_cast<TuyaCommand>(_rxCommand))
+  {
+  case TuyaCommand::Heartbeats:
+  {
+    // 0x00 on the first heartbeat after a restart, 0x01 afterwards
+    uint8_t data[1] = {static_cast<uint8_t>(_heartbeatAnswered ? 0x01 : 0x00)};
+    sendFrame(TuyaCommand::Heartbeats, data, sizeof(data));
+    _heartbeatAnswered = true;
+    break;
+  }
+  case TuyaCommand::QueryProductInfo:
+  {
+    const char *productInfo = _config.productInfo != nullptr ? _config.productInfo : "{}";
+    sendFrame(TuyaCommand::QueryProductInfo, reinterpret_cast<const uint8_t *>(productInfo), strlen(productInfo));
+    break;
+  }
+  case TuyaCommand::QueryWorkingMode:
+  case TuyaCommand::ReportNetworkStatus:
+    sendFrame(static_cast<TuyaCommand>(_rxCommand), nullptr, 0);
+    break;
+  case TuyaCommand::SendCommand:
+    if (_rxLength >= 8 && _rxData[1] == static_cast<uint8_t>(TuyaDataType::Value))
+    {
+      int32_t value = (static_cast<uint32_t>(_rxData[4]) << 24) |
+                      (static_cast<uint32_t>(_rxData[5]) << 16) |
+                      (static_cast<uint32_t>(_rxData[6]) << 8) |
+                      static_cast<uint32_t>(_rxData[7]);
+      if (setDp(_rxData[0], value))
+      {
+        Dp *entry = findDp(_rxData[0]);
+        uint16_t noise = entry->noise;
+        entry->noise = 0;
+        reportDp(entry->id);
+        entry->noise = noise;
+      }
+    }
+    break;
+  case TuyaCommand::QueryDpStatus:
+    for (uint8_t i = 0; i < _dpCount; i++)
+    {
+      reportDp(_dps[i].id);
+    }
+    break;
+  case TuyaCommand::StartOta:
+  {
+    uint8_t data[1] = {0x00}; // 256-byte packets
+    sendFrame(TuyaCommand::StartOta, data, sizeof(data));
+    break;
+  }
+  case TuyaCommand::TransmitOtaData:
+    if (_rxLength >= 4)
+      _stats.otaBytes += _rxLength - 4;
+    sendFrame(TuyaCommand::TransmitOtaData, nullptr, 0);
+    break;
+  default:
+    break;
+  }
+}
+
+void TuyaMcuSimulator::sendFrame(TuyaCommand command, const uint8_t *data, uint16_t length)
+{
+  uint16_t frameLength = length + 7;
+  if (_pendingCount >= sizeof(_pendingFrames) / sizeof(_pendingFrames[0]) ||
+      _pending.getCapacity() - _pending.available() < frameLength)
+  {
+    _stats.bytesDropped += frameLength;
+    return;
+  }
+
+  uint8_t header[6] = {
+      0x55, 0xAA,
+      static_cast<uint8_t>(TuyaDeviceType::MCU),
+      static_cast<uint8_t>(command),
+      static_cast<uint8_t>(length >> 8),
+      static_cast<uint8_t>(length)};
+  uint8_t checksum = 0;
+
+  // Corruption is applied after the checksum is taken so the module sees it
+  for (uint16_t i = 0; i < frameLength; i++)
+  {
+    uint8_t byte;
+    if (i < sizeof(header))
+      byte = header[i];
+    else if (i < frameLength - 1)
+      byte = data[i - sizeof(header)];
+    else
+      byte = checksum;
+    checksum += byte;
+
+    if (_config.corruptPerMille > 0 && nextRandom() % 1000 < _config.corruptPerMille)
+    {
+      byte ^= 1 << (nextRandom() % 8);
+      _stats.bytesCorrupted++;
+    }
+    _pending.push(byte);
+  }
+
+  uint8_t tail = (_pendingHead + _pendingCount) % (sizeof(_pendingFrames) / sizeof(_pendingFrames[0]));
+  _pendingFrames[tail] = {static_cast<uint32_t>(millis()) + _config.latencyMs, frameLength};
+  _pendingCount++;
+  _stats.framesSent++;
+}
+
+void TuyaMcuSimulator::sendReports()
+{
+  if (_config.reportIntervalMs == 0 || _dpCount == 0)
+    return;
+
+  uint32_t now = millis();
+  if (now - _lastReportMs < _config.reportIntervalMs)
+    return;
+  _lastReportMs = now;
+
+  uint16_t burst = _config.reportBurst > 0 ? _config.reportBurst : 1;
+  for (uint16_t i = 0; i < burst; i++)
+  {
+    reportDp(_dps[_nextReportDp].id);
+    _nextReportDp = (_nextReportDp + 1) % _dpCount;
+  }
+}
+
+void TuyaMcuSimulator::release()
+{
+  uint32_t now = millis();
+  uint32_t budget = _config.maxChunk > 0 ? _config.maxChunk : UINT32_MAX;
+  uint8_t chunk[32];
+
+  while (_pendingCount > 0 && budget > 0)
+  {
+    PendingFrame &frame = _pendingFrames[_pendingHead];
+    if (static_cast<int32_t>(now - frame.readyMs) < 0)
+      break;
+
+    uint32_t count = frame.length < budget ? frame.length : budget;
+    if (count > sizeof(chunk))
+      count = sizeof(chunk);
+    _pending.read(chunk, count);
+    size_t written = _link->write(chunk, count);
+    _stats.bytesDropped += count - written;
+
+    frame.length -= count;
+    budget -= count;
+    if (frame.length == 0)
+    {
+      _pendingHead = (_pendingHead + 1) % (sizeof(_pendingFrames) / sizeof(_pendingFrames[0]));
+      _pendingCount--;
+    }
+  }
+}
+
+TuyaMcuSimulator::Dp *TuyaMcuSimulator::findDp(uint8_t dp)
+{
+  for (uint8_t i = 0; i < _dpCount; i++)
+  {
+    if (_dps[i].id == dp)
+      return &_dps[i];
+  }
+  return nullptr;
+}
+
+uint32_t TuyaMcuSimulator::nextRandom()
+{
+  // xorshift32
+  _random ^= _random << 13;
+  _random ^= _random >> 17;
+  _random ^= _random << 5;
+  return _random;
+}
@@ -0,0 +1,403 @@
+#include "tuya_ota.h"
+#include "tuya.h"
+#include "tuya_crc.h"
+
+#if TUYA_ENABLE_OTA
+
+namespace
+{
+  constexpr uint8_t OTA_BLOCK_SIZE = 32;
+
+  uint16_t packetSizeFromReply(uint8_t reply)
+  {
+    switch (reply)
+    {
+    case 0x00:
+      return 256;
+    case 0x01:
+      return 512;
+    case 0x02:
+      return 1024;
+    default:
+      return 0;
+    }
+  }
+}
+
+// =======================
+// TuyaOtaSource
+// =======================
+
+uint32_t TuyaOtaSource::capacity() const
+{
+  return size();
+}
+
+bool TuyaOtaSource::ready(uint32_t, uint16_t)
+{
+  return true;
+}
+
+void TuyaOtaSource::release(uint32_t)
+{
+}
+
+TuyaOtaMemorySource::TuyaOtaMemorySource(const uint8_t *data, uint32_t size)
+    : _data(data), _size(size)
+{
+}
+
+uint32_t TuyaOtaMemorySource::size() const
+{
+  return _size;
+}
+
+uint16_t TuyaOtaMemorySource::read(uint32_t offset, uint8_t *buffer, uint16_t length)
+{
+  if (offset >= _size)
+    return 0;
+  if (length > _size - offset)
+    length = _size - offset;
+  memcpy(buffer, _data + offset, length);
+  return length;
+}
+
+TuyaOtaStreamSource::TuyaOtaStreamSource(Stream &stream, uint32_t size, uint8_t *buffer, uint16_t bufferSize)
+    : _stream(stream), _size(size), _buffer(buffer), _bufferSize(bufferSize), _base(0), _filled(0)
+{
+}
+
+uint32_t TuyaOtaStreamSource::size() const
+{
+  return _size;
+}
+
+uint32_t TuyaOtaStreamSource::capacity() const
+{
+  return _bufferSize;
+}
+
+bool TuyaOtaStreamSource::ready(uint32_t offset, uint16_t length)
+{
+  if (offset < _base || offset + length - _base > _bufferSize)
+    return false;
+
+  uint32_t end = offset + length;
+  while (_base + _filled < end)
+  {
+    int available = _stream.available();
+    if (available <= 0)
+      return false;
+    uint16_t wanted = end - (_base + _filled);
+    if (static_cast<uint32_t>(available) < wanted)
+      wanted = available;
+    _filled += _stream.readBytes(_buffer + _filled, wanted);
+  }
+  return true;
+}
+
+uint16_t TuyaOtaStreamSource::read(uint32_t offset, uint8_t *buffer, uint16_t length)
+{
+  if (offset < _base || offset + length > _base + _filled)
+    return 0;
+  memcpy(buffer, _buffer + (offset - _base), length);
+  return length;
+}
+
+void TuyaOtaStreamSource::release(uint32_t offset)
+{
+  if (offset <= _base)
+    return;
+  uint32_t drop = offset - _base;
+  if (drop > _filled)
+    drop = _filled;
+  memmove(_buffer, _buffer + drop, _filled - drop);
+  _filled -= drop;
+  _base += drop;
+}
+
+// =======================
+// TuyaOta
+// =======================
+
+TuyaOta::TuyaOta()
+    : _serial(nullptr), _source(nullptr), _state(TuyaOtaState::Idle), _error(TuyaOtaError::None), _size(0), _packetSize(0),
+      _timeoutMs(5000), _maxRetries(3), _retries(0), _resends(0), _ackedOffset(0), _sentOffset(0), _crcOffset(0),
+      _crc32(0), _lastProgressMs(0)
+{
+}
+
+bool TuyaOta::begin(Stream *serial, TuyaOtaSource &source, uint32_t timeoutMs, uint8_t maxRetries)
+{
+  if (serial == nullptr || isActive() || source.size() == 0)
+    return false;
+
+  _serial = serial;
+  _source = &source;
+  _size = source.size();
+  _packetSize = 0;
+  _timeoutMs = timeoutMs;
+  _maxRetries = maxRetries;
+  _retries = 0;
+  _resends = 0;
+  _ackedOffset = 0;
+  _sentOffset = 0;
+  _crcOffset = 0;
+  _crc32 = TUYA_CRC32_INIT;
+  _error = TuyaOtaError::None;
+  _state = TuyaOtaState::Starting;
+
+  sendStartOta();
+  return true;
+}
+
+void TuyaOta::poll()
+{
+  if (!isActive())
+    return;
+
+  if (millis() - _lastProgressMs > _timeoutMs)
+  {
+    // Nothing in flight while transferring means the source never got ready
+    if (_state == TuyaOtaState::Transferring && !isPacketInFlight())
+    {
+      fail(TuyaOtaError::SourceStalled);
+      return;
+    }
+    retry();
+    if (!isActive())
+      return;
+  }
+
+  if (_state != TuyaOtaState::Transferring || isPacketInFlight() || _sentOffset >= _size)
+    return;
+
+  uint16_t length = packetLength(_sentOffset);
+  if (!_source->ready(_sentOffset, length))
+    return;
+  if (!sendPacket(_sentOffset, length))
+  {
+    fail(TuyaOtaError::SourceRead);
+    return;
+  }
+  _lastProgressMs = millis();
+  _sentOffset += length;
+}
+
+void TuyaOta::abort()
+{
+  if (isActive())
+    fail(TuyaOtaError::Aborted);
+}
+
+void TuyaOta::handleStartOta(const uint8_t *data, uint16_t length)
+{
+  if (_state != TuyaOtaState::Starting || length < 1)
+    return;
+
+  _packetSize = packetSizeFromReply(data[0]);
+  if (_packetSize == 0)
+  {
+    fail(TuyaOtaError::Rejected);
+    return;
+  }
+  if (_source->capacity() < packetLength(0))
+  {
+    fail(TuyaOtaError::SourceTooSmall);
+    return;
+  }
+
+  _retries = 0;
+  _lastProgressMs = millis();
+  _state = TuyaOtaState::Transferring;
+  poll();
+}
+
+void TuyaOta::handleTransmitOtaData()
+{
+  if (_state == TuyaOtaState::Finishing)
+  {
+    _state = TuyaOtaState::Done;
+    return;
+  }
+
+  if (_state != TuyaOtaState::Transferring || !isPacketInFlight())
+    return;
+
+  // The ack carries no offset; it is for the single packet in flight
+  _ackedOffset = _sentOffset;
+  _retries = 0;
+  _lastProgressMs = millis();
+  _source->release(_ackedOffset);
+
+  if (_ackedOffset >= _size)
+  {
+    // A zero-length packet at offset == size marks the end of the image
+    _state = TuyaOtaState::Finishing;
+    sendPacket(_size, 0);
+    return;
+  }
+
+  poll();
+}
+
+bool TuyaOta::isActive() const
+{
+  return _state == TuyaOtaState::Starting ||
+         _state == TuyaOtaState::Transferring ||
+         _state == TuyaOtaState::Finishing;
+}
+
+TuyaOtaState TuyaOta::getState() const
+{
+  return _state;
+}
+
+TuyaOtaError TuyaOta::getError() const
+{
+  return _error;
+}
+
+uint32_t TuyaOta::getSize() const
+{
+  return _size;
+}
+
+uint32_t TuyaOta::getAcknowledged() const
+{
+  return _ackedOffset;
+}
+
+uint16_t TuyaOta::getPacketSize() const
+{
+  return _packetSize;
+}
+
+uint32_t TuyaOta::getCrc32() const
+{
+  return ~_crc32;
+}
+
+uint32_t TuyaOta::getResends() const
+{
+  return _resends;
+}
+
+void TuyaOta::sendStartOta()
+{
+  uint8_t frame[11] = {
+      0x55, 0xAA,
+      static_cast<uint8_t>(TuyaDeviceType::Module),
+      static_cast<uint8_t>(TuyaCommand::StartOta),
+      0x00, 0x04,
+      static_cast<uint8_t>(_size >> 24),
+      static_cast<uint8_t>(_size >> 16),
+      static_cast<uint8_t>(_size >> 8),
+      static_cast<uint8_t>(_size),
+      0x00};
+  uint8_t checksum = 0;
+  for (uint8_t i = 0; i < sizeof(frame) - 1; i++)
+  {
+    checksum += frame[i];
+  }
+  frame[sizeof(frame) - 1] = checksum;
+
+  _serial->write(frame, sizeof(frame));
+  _lastProgressMs = millis();
+}
+
+bool TuyaOta::sendPacket(uint32_t offset, uint16_t length)
+{
+  uint16_t dataLength = length + 4;
+  uint8_t header[10] = {
+      0x55, 0xAA,
+      static_cast<uint8_t>(TuyaDeviceType::Module),
+      static_cast<uint8_t>(TuyaCommand::TransmitOtaData),
+      static_cast<uint8_t>(dataLength >> 8),
+      static_cast<uint8_t>(dataLength),
+      static_cast<uint8_t>(offset >> 24),
+      static_cast<uint8_t>(offset >> 16),
+      static_cast<uint8_t>(offset >> 8),
+      static_cast<uint8_t>(offset)};
+  uint8_t checksum = 0;
+  for (uint8_t i = 0; i < sizeof(header); i++)
+  {
+    checksum += header[i];
+  }
+  _serial->write(header, sizeof(header));
+
+  // Only the first transmission of a byte extends the running CRC
+  bool firstSend = offset == _crcOffset;
+  uint8_t block[OTA_BLOCK_SIZE];
+  uint16_t sent = 0;
+  while (sent < length)
+  {
+    uint16_t blockLength = length - sent;
+    if (blockLength > sizeof(block))
+      blockLength = sizeof(block);
+    if (_source->read(offset + sent, block, blockLength) != blockLength)
+      return false;
+    for (uint16_t i = 0; i < blockLength; i++)
+    {
+      checksum += block[i];
+    }
+    if (firstSend)
+      _crc32 = tuyaCrc32Update(_crc32, block, blockLength);
+    _serial->write(block, blockLength);
+    sent += blockLength;
+  }
+  if (firstSend)
+    _crcOffset += length;
+
+  _serial->write(checksum);
+  return true;
+}
+
+void TuyaOta::retry()
+{
+  if (++_retries > _maxRetries)
+  {
+    fail(TuyaOtaError::Timeout);
+    return;
+  }
+
+  switch (_state)
+  {
+  case TuyaOtaState::Starting:
+    sendStartOta();
+    break;
+  case TuyaOtaState::Transferring:
+    // Resend the unacknowledged packet
+    if (isPacketInFlight())
+      _resends++;
+    _sentOffset = _ackedOffset;
+    _lastProgressMs = millis();
+    break;
+  case TuyaOtaState::Finishing:
+    sendPacket(_size, 0);
+    _lastProgressMs = millis();
+    break;
+  default:
+    break;
+  }
+}
+
+void TuyaOta::fail(TuyaOtaError error)
+{
+  _state = TuyaOtaState::Failed;
+  _error = error;
+}
+
+bool TuyaOta::isPacketInFlight() const
+{
+  // Stop-and-wait: at most one packet is sent and not yet acknowledged
+  return _sentOffset != _ackedOffset;
+}
+
+uint16_t TuyaOta::packetLength(uint32_t offset) const
+{
+  uint32_t remaining = _size - offset;
+  return remaining < _packetSize ? remaining : _packetSize;
+}
+
+#endif
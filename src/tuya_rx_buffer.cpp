@@ -0,0 +1,126 @@
+#include "tuya_rx_buffer.h"
+
+namespace
+{
+  // Largest power of two not above capacity, 0 for 0
+  size_t floorPowerOfTwo(size_t capacity)
+  {
+    if (capacity == 0)
+      return 0;
+    size_t power = 1;
+    while (power <= capacity / 2)
+      power <<= 1;
+    return power;
+  }
+}
+
+TuyaRxBuffer::TuyaRxBuffer(uint8_t *storage, size_t capacity)
+    : _storage(storage), _capacity(floorPowerOfTwo(capacity)), _mask(_capacity - 1),
+      _head(0), _tail(0), _overruns(0), _highWatermark(0)
+{
+}
+
+TUYA_ISR_ATTR bool TuyaRxBuffer::push(uint8_t byte)
+{
+  uint32_t head = _head.load(std::memory_order_relaxed);
+  uint32_t tail = _tail.load(std::memory_order_acquire);
+  uint32_t used = head - tail;
+  if (used >= _capacity)
+  {
+    _overruns.store(_overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  _storage[head & _mask] = byte;
+  _head.store(head + 1, std::memory_order_release);
+  updateHighWatermark(used + 1);
+  return true;
+}
+
+TUYA_ISR_ATTR size_t TuyaRxBuffer::push(const uint8_t *data, size_t length)
+{
+  uint32_t head = _head.load(std::memory_order_relaxed);
+  uint32_t tail = _tail.load(std::memory_order_acquire);
+  uint32_t space = _capacity - (head - tail);
+  size_t count = length < space ? length : space;
+  if (count < length)
+  {
+    _overruns.store(_overruns.load(std::memory_order_relaxed) + (length - count), std::memory_order_relaxed);
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    _storage[(head + i) & _mask] = data[i];
+  }
+  _head.store(head + count, std::memory_order_release);
+  updateHighWatermark(head + count - tail);
+  return count;
+}
+
+size_t TuyaRxBuffer::pump(Stream &stream)
+{
+  uint8_t chunk[32];
+  size_t total = 0;
+  int pending = stream.available();
+  while (pending > 0)
+  {
+    size_t wanted = static_cast<size_t>(pending) < sizeof(chunk) ? pending : sizeof(chunk);
+    size_t count = stream.readBytes(chunk, wanted);
+    if (count == 0)
+      break;
+    total += push(chunk, count);
+    pending -= count;
+  }
+  return total;
+}
+
+size_t TuyaRxBuffer::available() const
+{
+  return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+}
+
+size_t TuyaRxBuffer::read(uint8_t *data, size_t length)
+{
+  uint32_t tail = _tail.load(std::memory_order_relaxed);
+  uint32_t head = _head.load(std::memory_order_acquire);
+  size_t count = head - tail;
+  if (count > length)
+    count = length;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    data[i] = _storage[(tail + i) & _mask];
+  }
+  _tail.store(tail + count, std::memory_order_release);
+  return count;
+}
+
+size_t TuyaRxBuffer::getCapacity() const
+{
+  return _capacity;
+}
+
+uint32_t TuyaRxBuffer::getOverruns() const
+{
+  return _overruns.load(std::memory_order_relaxed);
+}
+
+size_t TuyaRxBuffer::getHighWatermark() const
+{
+  return _highWatermark.load(std::memory_order_relaxed);
+}
+
+void TuyaRxBuffer::resetStatistics()
+{
+  _overruns.store(0, std::memory_order_relaxed);
+  _highWatermark.store(0, std::memory_order_relaxed);
+}
+
+TUYA_ISR_ATTR void TuyaRxBuffer::updateHighWatermark(uint32_t used)
+{
+  // Only the producer writes the watermark, so a plain compare is enough
+  if (used > _highWatermark.load(std::memory_order_relaxed))
+  {
+    _highWatermark.store(used, std::memory_order_relaxed);
+  }
+}
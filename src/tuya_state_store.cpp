@@ -0,0 +1,97 @@
+#include "tuya_state_store.h"
+#include "tuya_crc.h"
+
+#if TUYA_ENABLE_WARM_START
+
+namespace
+{
+  constexpr uint32_t STATE_MAGIC = 0x54535431; // "TST1"
+  constexpr uint16_t STATE_FORMAT_VERSION = 1;
+}
+
+bool TuyaStateStore::writeRecord(const uint8_t *payload, uint16_t length)
+{
+  if (length > payloadCapacity)
+    return false;
+
+  uint32_t words[capacityWords] = {};
+  words[0] = STATE_MAGIC;
+  words[1] = (static_cast<uint32_t>(STATE_FORMAT_VERSION) << 16) | length;
+  words[2] = ~tuyaCrc32Update(TUYA_CRC32_INIT, payload, length);
+  memcpy(words + headerWords, payload, length);
+  return save(words, headerWords + (length + 3) / 4);
+}
+
+int16_t TuyaStateStore::readRecord(uint8_t *payload, uint16_t capacity)
+{
+  uint32_t words[capacityWords];
+  if (!load(words, headerWords))
+    return -1;
+
+  uint16_t length = words[1] & 0xFFFF;
+  if (words[0] != STATE_MAGIC || (words[1] >> 16) != STATE_FORMAT_VERSION || length > payloadCapacity ||
+      length > capacity)
+    return -1;
+
+  if (!load(words, headerWords + (length + 3) / 4))
+    return -1;
+
+  const uint8_t *stored = reinterpret_cast<const uint8_t *>(words + headerWords);
+  if (~tuyaCrc32Update(TUYA_CRC32_INIT, stored, length) != words[2])
+    return -1;
+
+  memcpy(payload, stored, length);
+  return length;
+}
+
+bool TuyaStateStore::invalidate()
+{
+  uint32_t words[headerWords] = {};
+  return save(words, headerWords);
+}
+
+// =======================
+// TuyaMemoryStateStore
+// =======================
+
+TuyaMemoryStateStore::TuyaMemoryStateStore(uint32_t *words, uint16_t count) : _words(words), _count(count)
+{
+}
+
+bool TuyaMemoryStateStore::load(uint32_t *words, uint16_t count)
+{
+  if (count > _count)
+    return false;
+  memcpy(words, _words, count * sizeof(uint32_t));
+  return true;
+}
+
+bool TuyaMemoryStateStore::save(const uint32_t *words, uint16_t count)
+{
+  if (count > _count)
+    return false;
+  memcpy(_words, words, count * sizeof(uint32_t));
+  return true;
+}
+
+#if defined(ARDUINO_ARCH_ESP8266)
+// =======================
+// TuyaRtcStateStore
+// =======================
+
+TuyaRtcStateStore::TuyaRtcStateStore(uint8_t offset) : _offset(offset)
+{
+}
+
+bool TuyaRtcStateStore::load(uint32_t *words, uint16_t count)
+{
+  return ESP.rtcUserMemoryRead(_offset, words, count * sizeof(uint32_t));
+}
+
+bool TuyaRtcStateStore::save(const uint32_t *words, uint16_t count)
+{
+  return ESP.rtcUserMemoryWrite(_offset, const_cast<uint32_t *>(words), count * sizeof(uint32_t));
+}
+#endif
+
+#endif
@@ -1,19 +1,95 @@
 #include "tuya_water_quality.h"
+#include <math.h>
 
 TuyaWaterQuality::TuyaWaterQuality() : Tuya()
 {
   _onSensorDataCallback = nullptr;
   _sensorData = {
-      {0, 0, 0},
-      {0, 0, 0},
-      {0, 0, 0},
+      {0, 0, 0, 0},
+      {0, 0, 0, 0},
+      {0, 0, 0, 0},
   };
+  for (PendingRequest &request : _requests)
+  {
+    request = {};
+  }
+  _nextRequest = 0;
+  _reportSequence = 0;
+  _sensorDataChanged = false;
+}
+
+// =======================
+// TuyaRequest
+// =======================
+
+TuyaRequest::TuyaRequest() : _owner(nullptr), _slot(0), _generation(0)
+{
+}
+
+TuyaRequest::TuyaRequest(TuyaWaterQuality *owner, uint8_t slot, uint32_t generation)
+    : _owner(owner), _slot(slot), _generation(generation)
+{
+}
+
+TuyaRequestState TuyaRequest::getState() const
+{
+  if (_owner == nullptr)
+    return TuyaRequestState::Invalid;
+
+  const TuyaWaterQuality::PendingRequest &request = _owner->_requests[_slot];
+  if (request.generation != _generation)
+    return TuyaRequestState::Invalid;
+  if (request.state == TuyaRequestState::Pending && static_cast<int32_t>(millis() - request.deadlineMs) >= 0)
+    return TuyaRequestState::TimedOut;
+  return request.state;
+}
+
+bool TuyaRequest::isPending() const
+{
+  return getState() == TuyaRequestState::Pending;
 }
 
+double TuyaRequest::getValue() const
+{
+  if (getState() != TuyaRequestState::Done)
+    return 0;
+  return _owner->_requests[_slot].value;
+}
+
+#if TUYA_HAS_COROUTINES
+bool TuyaRequest::await_ready() const
+{
+  return !isPending();
+}
+
+void TuyaRequest::await_suspend(std::coroutine_handle<> waiter) const
+{
+  _owner->_requests[_slot].waiter = waiter;
+}
+
+TuyaRequestState TuyaRequest::await_resume() const
+{
+  return getState();
+}
+#endif
+
+// =======================
+// TuyaWaterQuality
+// =======================
+
 bool TuyaWaterQuality::queryStatus()
 {
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::QueryDpStatus);
-  return sendFrame(frame);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::QueryDpStatus);
+  return queueFrame(frame, TuyaTxPriority::Low);
+}
+
+TuyaRequest TuyaWaterQuality::queryStatusAsync(TuyaWaterQualityDp dp, uint32_t timeoutMs)
+{
+  TuyaRequest handle;
+  PendingRequest *request = reserveRequest(dp, timeoutMs, handle);
+  if (request != nullptr && !queryStatus())
+    request->state = TuyaRequestState::Failed;
+  return handle;
 }
 
 double TuyaWaterQuality::getTemperature() const
@@ -31,6 +107,31 @@ int32_t TuyaWaterQuality::getTds() const
   return static_cast<int32_t>(_sensorData.tds.value);
 }
 
+void TuyaWaterQuality::getSnapshot(TuyaWaterQualitySnapshot &snapshot) const
+{
+  _snapshot.read(snapshot);
+}
+
+uint32_t TuyaWaterQuality::getSnapshotGeneration() const
+{
+  return _snapshot.getGeneration();
+}
+
+double TuyaWaterQuality::getFilteredTemperature() const
+{
+  return _sensorData.temperature.filtered;
+}
+
+double TuyaWaterQuality::getFilteredPh() const
+{
+  return _sensorData.ph.filtered;
+}
+
+int32_t TuyaWaterQuality::getFilteredTds() const
+{
+  return static_cast<int32_t>(_sensorData.tds.filtered);
+}
+
 double TuyaWaterQuality::getMaxTemperature() const
 {
   return _sensorData.temperature.maxThreshold;
@@ -91,6 +192,36 @@ bool TuyaWaterQuality::setMinTds(int32_t value)
   return setThreshold(TuyaWaterQualityDp::LowTDSThreshold, value);
 }
 
+TuyaRequest TuyaWaterQuality::setMaxTemperatureAsync(double value, uint32_t timeoutMs)
+{
+  return setThresholdAsync(TuyaWaterQualityDp::HighTemperatureThreshold, toFixedPoint(TuyaWaterQualityDp::HighTemperatureThreshold, value), timeoutMs);
+}
+
+TuyaRequest TuyaWaterQuality::setMinTemperatureAsync(double value, uint32_t timeoutMs)
+{
+  return setThresholdAsync(TuyaWaterQualityDp::LowTemperatureThreshold, toFixedPoint(TuyaWaterQualityDp::LowTemperatureThreshold, value), timeoutMs);
+}
+
+TuyaRequest TuyaWaterQuality::setMaxPhAsync(double value, uint32_t timeoutMs)
+{
+  return setThresholdAsync(TuyaWaterQualityDp::HighPHThreshold, toFixedPoint(TuyaWaterQualityDp::HighPHThreshold, value), timeoutMs);
+}
+
+TuyaRequest TuyaWaterQuality::setMinPhAsync(double value, uint32_t timeoutMs)
+{
+  return setThresholdAsync(TuyaWaterQualityDp::LowPHThreshold, toFixedPoint(TuyaWaterQualityDp::LowPHThreshold, value), timeoutMs);
+}
+
+TuyaRequest TuyaWaterQuality::setMaxTdsAsync(int32_t value, uint32_t timeoutMs)
+{
+  return setThresholdAsync(TuyaWaterQualityDp::HighTDSThreshold, value, timeoutMs);
+}
+
+TuyaRequest TuyaWaterQuality::setMinTdsAsync(int32_t value, uint32_t timeoutMs)
+{
+  return setThresholdAsync(TuyaWaterQualityDp::LowTDSThreshold, value, timeoutMs);
+}
+
 void TuyaWaterQuality::onSensorData(void (*callback)(TuyaWaterQualitySensorData &sensorData))
 {
   _onSensorDataCallback = callback;
@@ -98,73 +229,202 @@ void TuyaWaterQuality::onSensorData(void (*callback)(TuyaWaterQualitySensorData
 
 bool TuyaWaterQuality::decodeReportStatusAsync(TuyaFrame &frame)
 {
-  TuyaWaterQualityDp dpId = static_cast<TuyaWaterQualityDp>(frame.data[0]);
-  TuyaDataType dataType = static_cast<TuyaDataType>(frame.data[1]);
-  if (dataType != TuyaDataType::Value)
-    return false;
+  // Requests reserved while this report is decoded (e.g. from a subscriber)
+  // were sent after it, so resolveRequests() leaves them for a later report
+  _reportSequence++;
+
+  // Every DP of the frame is applied to _sensorData first, so readers of the
+  // snapshot and the callback never see a partly applied frame
+  _sensorDataChanged = false;
+  bool decoded = Tuya::decodeReportStatusAsync(frame);
+  if (!_sensorDataChanged)
+    return decoded;
+
+  TuyaWaterQualitySnapshot snapshot = {_sensorData, static_cast<uint32_t>(millis()), _snapshot.getGeneration() + 1, false};
+  _snapshot.publish(snapshot);
+
+  if (_onSensorDataCallback != nullptr)
+  {
+    _onSensorDataCallback(_sensorData);
+  }
+
+  markStateDirty();
+  return decoded;
+}
+
+bool TuyaWaterQuality::decodeDp(uint8_t dp, TuyaDataType dataType, const uint8_t *value, uint16_t valueLength)
+{
+  // DPs this class does not know still reach subscribers as raw updates
+  if (dataType != TuyaDataType::Value || valueLength != 4)
+    return Tuya::decodeDp(dp, dataType, value, valueLength);
 
-  uint32_t rawValue = decodeSensorRawValue(frame.data);
+  TuyaWaterQualityDp dpId = static_cast<TuyaWaterQualityDp>(dp);
+  uint32_t rawValue = decodeSensorRawValue(value);
+  TuyaEventType eventType = TuyaEventType::ThresholdChange;
+  double decoded;
 
   switch (dpId)
   {
   case TuyaWaterQualityDp::Temperature:
-    _sensorData.temperature.value = rawValue / 10.0;
+    eventType = TuyaEventType::DpUpdate;
+    decoded = _sensorData.temperature.value = rawValue / 10.0;
+    _sensorData.temperature.filtered = _temperatureFilter.update(static_cast<int32_t>(rawValue)) / 10.0;
     break;
   case TuyaWaterQualityDp::HighTemperatureThreshold:
-    _sensorData.temperature.maxThreshold = rawValue / 10.0;
+    decoded = _sensorData.temperature.maxThreshold = rawValue / 10.0;
     break;
   case TuyaWaterQualityDp::LowTemperatureThreshold:
-    _sensorData.temperature.minThreshold = rawValue / 10.0;
+    decoded = _sensorData.temperature.minThreshold = rawValue / 10.0;
     break;
   case TuyaWaterQualityDp::PH:
-    _sensorData.ph.value = rawValue / 100.0;
+    eventType = TuyaEventType::DpUpdate;
+    decoded = _sensorData.ph.value = rawValue / 100.0;
+    _sensorData.ph.filtered = _phFilter.update(static_cast<int32_t>(rawValue)) / 100.0;
     break;
   case TuyaWaterQualityDp::HighPHThreshold:
-    _sensorData.ph.maxThreshold = rawValue / 100.0;
+    decoded = _sensorData.ph.maxThreshold = rawValue / 100.0;
     break;
   case TuyaWaterQualityDp::LowPHThreshold:
-    _sensorData.ph.minThreshold = rawValue / 100.0;
+    decoded = _sensorData.ph.minThreshold = rawValue / 100.0;
     break;
   case TuyaWaterQualityDp::TDS:
-    _sensorData.tds.value = rawValue;
+    eventType = TuyaEventType::DpUpdate;
+    decoded = _sensorData.tds.value = rawValue;
+    _sensorData.tds.filtered = _tdsFilter.update(static_cast<int32_t>(rawValue));
     break;
   case TuyaWaterQualityDp::HighTDSThreshold:
-    _sensorData.tds.maxThreshold = rawValue;
+    decoded = _sensorData.tds.maxThreshold = rawValue;
     break;
   case TuyaWaterQualityDp::LowTDSThreshold:
-    _sensorData.tds.minThreshold = rawValue;
+    decoded = _sensorData.tds.minThreshold = rawValue;
     break;
   default:
-    return false;
+    return Tuya::decodeDp(dp, dataType, value, valueLength);
   }
 
-  if (_onSensorDataCallback != nullptr)
+  _sensorDataChanged = true;
+  resolveRequests(dpId, static_cast<int32_t>(rawValue), decoded);
+
+  TuyaEvent event = createEvent(eventType);
+  event.dp = dp;
+  event.dataType = dataType;
+  event.value = value;
+  event.valueLength = valueLength;
+  event.view = &_sensorData;
+  publishEvent(event);
+
+  return true;
+}
+
+void TuyaWaterQuality::poll()
+{
+  uint32_t now = millis();
+  for (PendingRequest &request : _requests)
   {
-    _onSensorDataCallback(_sensorData);
+    if (request.state == TuyaRequestState::Pending && static_cast<int32_t>(now - request.deadlineMs) >= 0)
+    {
+      request.state = TuyaRequestState::TimedOut;
+    }
   }
 
+#if TUYA_HAS_COROUTINES
+  // Waiters resume here, once every received frame is decoded, so the next
+  // request of a continuation cannot be resolved by the report that finished
+  // the previous one
+  for (PendingRequest &request : _requests)
+  {
+    if (request.state != TuyaRequestState::Pending && request.waiter)
+    {
+      std::coroutine_handle<> waiter = request.waiter;
+      request.waiter = nullptr;
+      waiter.resume();
+    }
+  }
+#endif
+}
+
+#if TUYA_ENABLE_WARM_START
+uint16_t TuyaWaterQuality::saveState(uint8_t *data, uint16_t capacity) const
+{
+  if (capacity < sizeof(_sensorData))
+    return 0;
+  memcpy(data, &_sensorData, sizeof(_sensorData));
+  return sizeof(_sensorData);
+}
+
+bool TuyaWaterQuality::restoreState(const uint8_t *data, uint16_t length)
+{
+  // A record without readings still restores the handshake
+  if (length == 0)
+    return true;
+  if (length != sizeof(_sensorData))
+    return false;
+
+  memcpy(&_sensorData, data, sizeof(_sensorData));
+  TuyaWaterQualitySnapshot snapshot = {_sensorData, static_cast<uint32_t>(millis()), _snapshot.getGeneration() + 1, true};
+  _snapshot.publish(snapshot);
   return true;
 }
+#endif
 
-uint32_t TuyaWaterQuality::decodeSensorRawValue(const uint8_t *data) const
+TuyaWaterQuality::PendingRequest *TuyaWaterQuality::reserveRequest(TuyaWaterQualityDp dp, uint32_t timeoutMs, TuyaRequest &handle)
 {
-  return (static_cast<uint32_t>(data[4]) << 24) |
-         (static_cast<uint32_t>(data[5]) << 16) |
-         (static_cast<uint32_t>(data[6]) << 8) |
-         (static_cast<uint32_t>(data[7]));
+  // Reuse the oldest slot that is not still waiting for the MCU. The slot is
+  // taken before the command is queued so a sent command always has a handle.
+  for (uint8_t i = 0; i < TUYA_MAX_PENDING_REQUESTS; i++)
+  {
+    uint8_t slot = (_nextRequest + i) % TUYA_MAX_PENDING_REQUESTS;
+    PendingRequest &request = _requests[slot];
+    if (request.state == TuyaRequestState::Pending)
+      continue;
+
+    request.dp = dp;
+    request.state = TuyaRequestState::Pending;
+    request.generation++;
+    request.reportSequence = _reportSequence;
+    request.matchValue = false;
+    request.rawValue = 0;
+    request.deadlineMs = millis() + timeoutMs;
+    request.value = 0;
+#if TUYA_HAS_COROUTINES
+    request.waiter = nullptr;
+#endif
+    _nextRequest = (slot + 1) % TUYA_MAX_PENDING_REQUESTS;
+    handle = TuyaRequest(this, slot, request.generation);
+    return &request;
+  }
+  handle = TuyaRequest();
+  return nullptr;
+}
+
+void TuyaWaterQuality::resolveRequests(TuyaWaterQualityDp dp, int32_t rawValue, double value)
+{
+  for (PendingRequest &request : _requests)
+  {
+    if (request.state != TuyaRequestState::Pending || request.dp != dp || request.reportSequence == _reportSequence)
+      continue;
+    // A report of another value (e.g. the old threshold) does not confirm a setter
+    if (request.matchValue && request.rawValue != rawValue)
+      continue;
+    request.value = value;
+    request.state = TuyaRequestState::Done;
+  }
+}
+
+uint32_t TuyaWaterQuality::decodeSensorRawValue(const uint8_t *value) const
+{
+  return (static_cast<uint32_t>(value[0]) << 24) |
+         (static_cast<uint32_t>(value[1]) << 16) |
+         (static_cast<uint32_t>(value[2]) << 8) |
+         (static_cast<uint32_t>(value[3]));
 }
 
 bool TuyaWaterQuality::setThreshold(TuyaWaterQualityDp dp, double value)
 {
-  // For temperature and pH, value is scaled (x10 or x100)
-  int32_t intValue;
-  if (dp == TuyaWaterQualityDp::HighTemperatureThreshold || dp == TuyaWaterQualityDp::LowTemperatureThreshold)
-    intValue = static_cast<int32_t>(value * 10);
-  else if (dp == TuyaWaterQualityDp::HighPHThreshold || dp == TuyaWaterQualityDp::LowPHThreshold)
-    intValue = static_cast<int32_t>(value * 100);
-  else
+  if (dp != TuyaWaterQualityDp::HighTemperatureThreshold && dp != TuyaWaterQualityDp::LowTemperatureThreshold &&
+      dp != TuyaWaterQualityDp::HighPHThreshold && dp != TuyaWaterQualityDp::LowPHThreshold)
     return false;
-  return setThreshold(dp, intValue);
+  return setThreshold(dp, toFixedPoint(dp, value));
 }
 
 bool TuyaWaterQuality::setThreshold(TuyaWaterQualityDp dp, int32_t value)
@@ -173,8 +433,40 @@ bool TuyaWaterQuality::setThreshold(TuyaWaterQualityDp dp, int32_t value)
   if (!buildSensorDataPayload(data, dp, value))
     return false;
 
-  TuyaFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::SendCommand, data, sizeof(data));
-  return sendFrame(frame);
+  TuyaTxFrame frame = createFrame(TuyaDeviceType::Module, TuyaCommand::SendCommand, data);
+  return queueFrame(frame);
+}
+
+TuyaRequest TuyaWaterQuality::setThresholdAsync(TuyaWaterQualityDp dp, int32_t value, uint32_t timeoutMs)
+{
+  TuyaRequest handle;
+  PendingRequest *request = reserveRequest(dp, timeoutMs, handle);
+  if (request == nullptr)
+    return handle;
+
+  request->matchValue = true;
+  request->rawValue = value;
+  if (!setThreshold(dp, value))
+    request->state = TuyaRequestState::Failed;
+  return handle;
+}
+
+int32_t TuyaWaterQuality::toFixedPoint(TuyaWaterQualityDp dp, double value) const
+{
+  // Temperature is sent x10 and pH x100; rounding keeps e.g. 8.2 from becoming 819
+  switch (dp)
+  {
+  case TuyaWaterQualityDp::Temperature:
+  case TuyaWaterQualityDp::HighTemperatureThreshold:
+  case TuyaWaterQualityDp::LowTemperatureThreshold:
+    return static_cast<int32_t>(lround(value * 10));
+  case TuyaWaterQualityDp::PH:
+  case TuyaWaterQualityDp::HighPHThreshold:
+  case TuyaWaterQualityDp::LowPHThreshold:
+    return static_cast<int32_t>(lround(value * 100));
+  default:
+    return static_cast<int32_t>(lround(value));
+  }
 }
 
 bool TuyaWaterQuality::buildSensorDataPayload(uint8_t (&buffer)[8], TuyaWaterQualityDp dp, int32_t value) const
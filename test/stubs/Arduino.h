@@ -0,0 +1,121 @@
+#pragma once
+
+// Minimal Arduino API for the native environments. Time is simulated:
+// millis() only advances through delay() or tuyaStubAdvance(). Programs that
+// talk to real devices (the Linux gateway and simulator) define
+// TUYA_STUB_REAL_CLOCK to read the monotonic clock instead.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#define HEX 16
+#define DEC 10
+
+using std::max;
+using std::min;
+
+#if defined(TUYA_STUB_REAL_CLOCK)
+inline unsigned long micros()
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return static_cast<unsigned long>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+inline unsigned long millis() { return micros() / 1000; }
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+#else
+inline unsigned long tuyaStubMillis = 0;
+
+inline unsigned long millis() { return tuyaStubMillis; }
+inline unsigned long micros() { return tuyaStubMillis * 1000; }
+inline void delay(unsigned long ms) { tuyaStubMillis += ms; }
+inline void tuyaStubAdvance(unsigned long ms) { tuyaStubMillis += ms; }
+#endif
+inline void yield() {}
+
+class String
+{
+public:
+  String() {}
+  String(const char *text) : _text(text != nullptr ? text : "") {}
+  String(const std::string &text) : _text(text) {}
+  String(int value) : _text(std::to_string(value)) {}
+  String(unsigned value) : _text(std::to_string(value)) {}
+  String(long value) : _text(std::to_string(value)) {}
+  String(unsigned long value) : _text(std::to_string(value)) {}
+  String(double value) : _text(std::to_string(value)) {}
+
+  void reserve(size_t size) { _text.reserve(size); }
+  const char *c_str() const { return _text.c_str(); }
+  size_t length() const { return _text.size(); }
+
+  String &operator+=(char c) { _text += c; return *this; }
+  String &operator+=(const char *text) { _text += text; return *this; }
+  String &operator+=(const String &other) { _text += other._text; return *this; }
+  bool operator==(const String &other) const { return _text == other._text; }
+  bool operator==(const char *text) const { return _text == text; }
+  bool operator!=(const String &other) const { return _text != other._text; }
+
+private:
+  std::string _text;
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t byte) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t written = 0;
+    for (size_t i = 0; i < size; i++)
+      written += write(buffer[i]);
+    return written;
+  }
+  size_t write(const char *text) { return write(reinterpret_cast<const uint8_t *>(text), strlen(text)); }
+  virtual void flush() {}
+  virtual int availableForWrite() { return 0; }
+
+  size_t print(const char *text) { return write(text); }
+  size_t print(const String &text) { return write(text.c_str()); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(int value, int = DEC) { return print(String(value)); }
+  size_t print(unsigned value, int = DEC) { return print(String(value)); }
+  size_t print(long value, int = DEC) { return print(String(value)); }
+  size_t print(unsigned long value, int = DEC) { return print(String(value)); }
+  size_t print(unsigned char value, int = DEC) { return print(String(static_cast<unsigned>(value))); }
+  size_t print(double value, int = 2) { return print(String(value)); }
+  size_t println() { return write("\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  size_t readBytes(uint8_t *buffer, size_t length)
+  {
+    size_t count = 0;
+    while (count < length)
+    {
+      int c = read();
+      if (c < 0)
+        break;
+      buffer[count++] = static_cast<uint8_t>(c);
+    }
+    return count;
+  }
+  size_t readBytes(char *buffer, size_t length) { return readBytes(reinterpret_cast<uint8_t *>(buffer), length); }
+  void setTimeout(unsigned long) {}
+};
@@ -0,0 +1,165 @@
+#include <unity.h>
+#include <tuya_water_quality.h>
+#include <tuya_fd_stream.h>
+#include <tuya_mcu_simulator.h>
+
+// The Linux transport: a simulated MCU on the master side of a
+// pseudo-terminal and the module on its slave device, as linux_simulator and
+// linux_gateway run them. Run with `pio test -e native`.
+
+#if defined(__linux__)
+
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+  struct PtyLink
+  {
+    TuyaFdStream mcuStream;
+    TuyaFdStream moduleStream;
+    TuyaMcuSimulator simulator;
+    TuyaWaterQuality sensor;
+  };
+
+  PtyLink *session = nullptr;
+
+  // Polls both ends until done() holds; the pty moves bytes asynchronously,
+  // so every round also gives the kernel a moment
+  template <typename Done>
+  bool runUntil(Done done)
+  {
+    for (int i = 0; i < 5000 && !done(); i++)
+    {
+      session->simulator.poll();
+      session->moduleStream.fill();
+      session->sensor.loop();
+      usleep(100);
+    }
+    return done();
+  }
+}
+
+void setUp()
+{
+  session = new PtyLink();
+  char slaveName[64];
+  TEST_ASSERT_TRUE(session->mcuStream.openPty(slaveName, sizeof(slaveName)));
+  TEST_ASSERT_TRUE(session->moduleStream.open(slaveName, 9600));
+
+  TuyaMcuSimulatorConfig config = {};
+  config.productInfo = "{\"product_id\":\"simulated\",\"version\":\"1.0.0\",\"operation_mode\":0}";
+  session->simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::PH), 701, 0);
+  session->simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::HighPHThreshold), 800, 0);
+  session->simulator.begin(&session->mcuStream, config);
+  session->sensor.begin(&session->moduleStream);
+  session->sensor.setDelay(1);
+}
+
+void tearDown()
+{
+  delete session;
+  session = nullptr;
+}
+
+void test_handshake_over_pty()
+{
+  TEST_ASSERT_TRUE(runUntil([] { return session->sensor.isVerified(); }));
+  TEST_ASSERT_TRUE(session->sensor.isInitialized());
+  TEST_ASSERT_EQUAL_STRING("simulated", session->sensor.getProductInfo().productId.c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, session->mcuStream.getWriteDrops());
+  TEST_ASSERT_EQUAL_UINT32(0, session->moduleStream.getWriteDrops());
+}
+
+void test_dp_round_trip_over_pty()
+{
+  TEST_ASSERT_TRUE(runUntil([] { return session->sensor.isVerified(); }));
+
+  TuyaRequest query = session->sensor.queryStatusAsync(TuyaWaterQualityDp::PH);
+  TEST_ASSERT_TRUE(runUntil([&] { return !query.isPending(); }));
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, query.getState());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.01, session->sensor.getPh());
+
+  TuyaRequest setter = session->sensor.setMaxPhAsync(7.5);
+  TEST_ASSERT_TRUE(runUntil([&] { return !setter.isPending(); }));
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, setter.getState());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.5, session->sensor.getMaxPh());
+  TEST_ASSERT_EQUAL_UINT32(0, session->simulator.getStats().checksumErrors);
+}
+
+void test_write_waits_for_the_reader()
+{
+  // Far more than the pty buffers; the module side drains it in the
+  // background, so the write blocks for a while but loses nothing
+  static uint8_t data[256 * 1024];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = static_cast<uint8_t>(i);
+  session->mcuStream.setWriteTimeout(2000);
+
+  size_t received = 0;
+  bool intact = true;
+  std::thread reader([&] {
+    int fd = session->moduleStream.getFd();
+    uint8_t chunk[4096];
+    for (int idle = 0; received < sizeof(data) && idle < 2000;)
+    {
+      ssize_t count = ::read(fd, chunk, sizeof(chunk));
+      if (count <= 0)
+      {
+        idle++;
+        usleep(500);
+        continue;
+      }
+      for (ssize_t i = 0; i < count; i++)
+        intact &= chunk[i] == static_cast<uint8_t>(received + i);
+      received += count;
+      idle = 0;
+    }
+  });
+  size_t written = session->mcuStream.write(data, sizeof(data));
+  reader.join();
+
+  TEST_ASSERT_EQUAL_UINT32(sizeof(data), written);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(data), received);
+  TEST_ASSERT_TRUE(intact);
+  TEST_ASSERT_EQUAL_UINT32(0, session->mcuStream.getWriteDrops());
+}
+
+void test_write_reports_a_stalled_reader()
+{
+  // Nobody reads the slave: the write gives up after the timeout and says so
+  static uint8_t data[256 * 1024];
+  session->mcuStream.setWriteTimeout(20);
+  size_t written = session->mcuStream.write(data, sizeof(data));
+
+  TEST_ASSERT_LESS_THAN_UINT32(sizeof(data), written);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(data) - written, session->mcuStream.getWriteDrops());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_handshake_over_pty);
+  RUN_TEST(test_dp_round_trip_over_pty);
+  RUN_TEST(test_write_waits_for_the_reader);
+  RUN_TEST(test_write_reports_a_stalled_reader);
+  return UNITY_END();
+}
+
+#else
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  return UNITY_END();
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include <unity.h>
+#include <tuya_filter.h>
+#include <algorithm>
+
+// Fixed-point denoising stages of tuya_filter.h. Run with `pio test -e native`.
+
+namespace
+{
+  // Deterministic samples spanning negative and positive DP values
+  int32_t nextSample(uint32_t &seed)
+  {
+    seed = seed * 1103515245u + 12345u;
+    return static_cast<int32_t>((seed >> 16) % 2001) - 1000;
+  }
+
+  // Median of the last Size samples, from a sorted copy of the window
+  template <uint8_t Size>
+  void checkMedianAgainstSort()
+  {
+    TuyaMedianFilter<Size> filter;
+    int32_t history[500];
+    uint32_t seed = Size;
+    for (uint16_t i = 0; i < 500; i++)
+    {
+      history[i] = nextSample(seed);
+      // Repeats exercise equal keys in the sorted window
+      if (i % 7 == 0 && i > 0)
+        history[i] = history[i - 1];
+
+      uint16_t count = i + 1 < Size ? i + 1 : Size;
+      int32_t window[Size];
+      std::copy(history + i + 1 - count, history + i + 1, window);
+      std::sort(window, window + count);
+      TEST_ASSERT_EQUAL_INT32(window[count / 2], filter.update(history[i]));
+    }
+  }
+
+  // Distance from target after feeding it `updates` times
+  template <typename Filter>
+  int32_t settle(Filter &filter, int32_t target, uint16_t updates)
+  {
+    int32_t output = 0;
+    for (uint16_t i = 0; i < updates; i++)
+      output = filter.update(target);
+    return output - target;
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_median_matches_sorted_window()
+{
+  checkMedianAgainstSort<1>();
+  checkMedianAgainstSort<4>();
+  checkMedianAgainstSort<5>();
+  checkMedianAgainstSort<9>();
+}
+
+void test_median_drops_a_spike()
+{
+  TuyaMedianFilter<5> filter;
+  const int32_t samples[] = {701, 702, 9999, 701, 703};
+  int32_t output = 0;
+  for (int32_t sample : samples)
+    output = filter.update(sample);
+  TEST_ASSERT_EQUAL_INT32(702, output);
+}
+
+void test_ema_converges_from_both_sides()
+{
+  TuyaEmaFilter<3> filter;
+  TEST_ASSERT_EQUAL_INT32(250, filter.update(250));
+  TEST_ASSERT_EQUAL_INT32(0, settle(filter, -125, 200));
+  TEST_ASSERT_EQUAL_INT32(0, settle(filter, 300, 200));
+
+  // The first steps move by alpha of the distance, in either direction
+  TuyaEmaFilter<1> half;
+  half.update(0);
+  TEST_ASSERT_EQUAL_INT32(-50, half.update(-100));
+  TEST_ASSERT_EQUAL_INT32(-75, half.update(-100));
+}
+
+void test_kalman_converges_from_both_sides()
+{
+  TuyaKalmanFilter<1, 16> filter;
+  TEST_ASSERT_EQUAL_INT32(250, filter.update(250));
+  TEST_ASSERT_EQUAL_INT32(0, settle(filter, -125, 500));
+  TEST_ASSERT_EQUAL_INT32(0, settle(filter, 300, 500));
+}
+
+void test_kalman_is_symmetric_for_negative_samples()
+{
+  // Samples used to be scaled with << 8, undefined for negative values
+  // before C++20; mirrored inputs must give exactly mirrored outputs
+  TuyaKalmanFilter<4, 9> positive;
+  TuyaKalmanFilter<4, 9> negative;
+  uint32_t seed = 7;
+  for (uint16_t i = 0; i < 200; i++)
+  {
+    int32_t sample = nextSample(seed);
+    TEST_ASSERT_EQUAL_INT32(positive.update(sample), -negative.update(-sample));
+  }
+
+  TuyaKalmanFilter<4, 9> primed;
+  TEST_ASSERT_EQUAL_INT32(-2000000, primed.update(-2000000));
+  TEST_ASSERT_EQUAL_INT32(-2000000, primed.update(-2000000));
+}
+
+void test_chain_runs_both_stages()
+{
+  TuyaFilterChain<TuyaMedianFilter<3>, TuyaEmaFilter<1>> filter;
+  filter.update(100);
+  filter.update(100);
+  // The spike is removed by the median before it reaches the EMA
+  TEST_ASSERT_EQUAL_INT32(100, filter.update(5000));
+  TEST_ASSERT_EQUAL_INT32(0, settle(filter, -40, 50));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_median_matches_sorted_window);
+  RUN_TEST(test_median_drops_a_spike);
+  RUN_TEST(test_ema_converges_from_both_sides);
+  RUN_TEST(test_kalman_converges_from_both_sides);
+  RUN_TEST(test_kalman_is_symmetric_for_negative_samples);
+  RUN_TEST(test_chain_runs_both_stages);
+  return UNITY_END();
+}
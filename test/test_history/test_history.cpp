@@ -0,0 +1,196 @@
+#include <unity.h>
+#include <tuya_history.h>
+#include <vector>
+
+// Downsampling and delta encoding of sensor history. Run with
+// `pio test -e native`.
+
+namespace
+{
+  class BufferPrint : public Print
+  {
+  public:
+    size_t write(uint8_t byte) override
+    {
+      bytes.push_back(byte);
+      return 1;
+    }
+
+    std::vector<uint8_t> bytes;
+  };
+
+  class SampleLog : public TuyaHistorySink
+  {
+  public:
+    void write(const TuyaHistorySample &sample) override { samples.push_back(sample); }
+
+    std::vector<TuyaHistorySample> samples;
+  };
+
+  void assertSameSample(const TuyaHistorySample &expected, const TuyaHistorySample &actual)
+  {
+    TEST_ASSERT_EQUAL_UINT32(expected.timestamp, actual.timestamp);
+    TEST_ASSERT_EQUAL_INT32(expected.temperature, actual.temperature);
+    TEST_ASSERT_EQUAL_INT32(expected.ph, actual.ph);
+    TEST_ASSERT_EQUAL_INT32(expected.tds, actual.tds);
+  }
+
+  // Encodes the samples, decodes them back and compares every field
+  void assertRoundTrip(const std::vector<TuyaHistorySample> &samples)
+  {
+    BufferPrint out;
+    TuyaHistoryEncoder encoder(out);
+    for (const TuyaHistorySample &sample : samples)
+      encoder.write(sample);
+    TEST_ASSERT_EQUAL_UINT32(samples.size(), encoder.getSampleCount());
+    TEST_ASSERT_EQUAL_UINT32(out.bytes.size(), encoder.getByteCount());
+
+    TuyaHistoryDecoder decoder(out.bytes.data(), out.bytes.size());
+    TuyaHistorySample decoded;
+    for (const TuyaHistorySample &sample : samples)
+    {
+      TEST_ASSERT_TRUE(decoder.next(decoded));
+      assertSameSample(sample, decoded);
+    }
+    TEST_ASSERT_FALSE(decoder.next(decoded));
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_round_trip_of_a_steady_series()
+{
+  std::vector<TuyaHistorySample> samples;
+  for (uint32_t i = 0; i < 1000; i++)
+    samples.push_back({1700000000 + i * 10, 253 + static_cast<int32_t>(i % 3) - 1, 701, 300 - static_cast<int32_t>(i % 5)});
+  assertRoundTrip(samples);
+
+  // Constant interval and small changes: 1 byte per field after the first
+  BufferPrint out;
+  TuyaHistoryEncoder encoder(out);
+  for (const TuyaHistorySample &sample : samples)
+    encoder.write(sample);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(3 + 16 + (samples.size() - 1) * 4, encoder.getByteCount());
+}
+
+void test_round_trip_of_extreme_deltas()
+{
+  // Full-range jumps in every field, timestamps wrapping both ways and
+  // alternating intervals that flip the sign of the delta-of-delta
+  const std::vector<TuyaHistorySample> samples = {
+      {0, 0, 0, 0},
+      {UINT32_MAX, INT32_MAX, INT32_MIN, INT32_MAX},
+      {0, INT32_MIN, INT32_MAX, INT32_MIN},
+      {UINT32_MAX, INT32_MAX, INT32_MIN, INT32_MAX},
+      {UINT32_MAX, INT32_MAX, INT32_MIN, INT32_MAX},
+      {1, -1, 1, -1},
+      {0x80000000u, 0, 0, 0},
+      {0x7FFFFFFFu, -2000, 1400, 0},
+  };
+  assertRoundTrip(samples);
+}
+
+void test_truncated_stream_stops_decoding()
+{
+  BufferPrint out;
+  TuyaHistoryEncoder encoder(out);
+  encoder.write({100, 250, 700, 300});
+  encoder.write({110, INT32_MAX, INT32_MIN, 0});
+
+  // Cut inside the second sample: the first still decodes, the rest is refused
+  TuyaHistoryDecoder decoder(out.bytes.data(), out.bytes.size() - 2);
+  TuyaHistorySample decoded;
+  TEST_ASSERT_TRUE(decoder.next(decoded));
+  assertSameSample({100, 250, 700, 300}, decoded);
+  TEST_ASSERT_FALSE(decoder.next(decoded));
+
+  out.bytes[0] = 'X';
+  TuyaHistoryDecoder wrongMagic(out.bytes.data(), out.bytes.size());
+  TEST_ASSERT_FALSE(wrongMagic.next(decoded));
+}
+
+void test_day_in_one_bucket()
+{
+  // A day of 1 Hz samples in a single 86,400 s bucket. Every TDS sample is
+  // at INT32_MAX, so the sum only fits in the 64-bit accumulator.
+  SampleLog log;
+  TuyaHistoryDownsampler downsampler(log, 86400, true);
+  int64_t temperatureSum = 0;
+  for (uint32_t i = 0; i < 86400; i++)
+  {
+    int32_t temperature = static_cast<int32_t>(i % 101) - 50;
+    temperatureSum += temperature;
+    downsampler.add({86400 + i, temperature, i == 43200 ? 1400 : 700, INT32_MAX});
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, log.samples.size());
+
+  // The next day's first sample closes the bucket
+  downsampler.add({2 * 86400, 0, 0, 0});
+  const TuyaHistoryBucket &bucket = downsampler.getLastBucket();
+  TEST_ASSERT_EQUAL_UINT32(86400, bucket.start);
+  TEST_ASSERT_EQUAL_UINT32(86400, bucket.count);
+  TEST_ASSERT_EQUAL_INT32(-50, bucket.min.temperature);
+  TEST_ASSERT_EQUAL_INT32(50, bucket.max.temperature);
+  TEST_ASSERT_EQUAL_INT32(static_cast<int32_t>(temperatureSum / 86400), bucket.mean.temperature);
+  TEST_ASSERT_EQUAL_INT32(700, bucket.min.ph);
+  TEST_ASSERT_EQUAL_INT32(1400, bucket.max.ph);
+  TEST_ASSERT_EQUAL_INT32(700, bucket.mean.ph);
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, bucket.mean.tds);
+
+  // The envelope is written as min, mean and max, all at the bucket start
+  TEST_ASSERT_EQUAL_UINT32(3, log.samples.size());
+  assertSameSample(bucket.min, log.samples[0]);
+  assertSameSample(bucket.mean, log.samples[1]);
+  assertSameSample(bucket.max, log.samples[2]);
+  for (const TuyaHistorySample &sample : log.samples)
+    TEST_ASSERT_EQUAL_UINT32(86400, sample.timestamp);
+
+  downsampler.finish();
+  TEST_ASSERT_EQUAL_UINT32(6, log.samples.size());
+  TEST_ASSERT_EQUAL_UINT32(1, downsampler.getLastBucket().count);
+}
+
+void test_downsampled_series_round_trips()
+{
+  // Minute means of an hour of readings, encoded and decoded
+  BufferPrint out;
+  TuyaHistoryEncoder encoder(out);
+  SampleLog log;
+  TuyaHistoryDownsampler minutes(encoder, 60);
+  TuyaHistoryDownsampler reference(log, 60);
+  for (uint32_t t = 0; t < 3600; t += 5)
+  {
+    TuyaHistorySample sample = {t, 250 + static_cast<int32_t>(t % 7), 700 - static_cast<int32_t>(t % 11), 300};
+    minutes.add(sample);
+    reference.add(sample);
+  }
+  minutes.finish();
+  reference.finish();
+
+  TEST_ASSERT_EQUAL_UINT32(60, log.samples.size());
+  TuyaHistoryDecoder decoder(out.bytes.data(), out.bytes.size());
+  TuyaHistorySample decoded;
+  for (const TuyaHistorySample &sample : log.samples)
+  {
+    TEST_ASSERT_TRUE(decoder.next(decoded));
+    assertSameSample(sample, decoded);
+  }
+  TEST_ASSERT_FALSE(decoder.next(decoded));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_of_a_steady_series);
+  RUN_TEST(test_round_trip_of_extreme_deltas);
+  RUN_TEST(test_truncated_stream_stops_decoding);
+  RUN_TEST(test_day_in_one_bucket);
+  RUN_TEST(test_downsampled_series_round_trips);
+  return UNITY_END();
+}
@@ -0,0 +1,225 @@
+#include <unity.h>
+#include <tuya_water_quality.h>
+#include <tuya_mcu_simulator.h>
+
+// OTA transfers end to end against the simulated MCU, which asks for 256-byte
+// packets. Run with `pio test -e native`.
+
+namespace
+{
+  const uint32_t IMAGE_SIZE = 3000;
+
+  uint8_t image[IMAGE_SIZE];
+
+  // Serves a byte array, `limit` bytes at most, to stand in for a file or a
+  // network client that runs dry.
+  class ImageStream : public Stream
+  {
+  public:
+    ImageStream(const uint8_t *data, size_t length, size_t limit) : _data(data), _length(length), _limit(limit), _position(0) {}
+
+    int available() override { return static_cast<int>(min(_length, _limit) - _position); }
+    int read() override { return available() > 0 ? _data[_position++] : -1; }
+    int peek() override { return available() > 0 ? _data[_position] : -1; }
+    size_t write(uint8_t) override { return 0; }
+
+  private:
+    const uint8_t *_data;
+    size_t _length;
+    size_t _limit;
+    size_t _position;
+  };
+
+  struct Link
+  {
+    TuyaMcuSimulator simulator;
+    TuyaWaterQuality sensor;
+  };
+
+  // Large members; kept off the stack
+  Link *session = nullptr;
+
+  void setUpLink(uint16_t corruptPerMille)
+  {
+    delete session;
+    session = new Link();
+    TuyaMcuSimulatorConfig config = {};
+    config.productInfo = "{\"product_id\":\"simulated\",\"version\":\"1.0.0\"}";
+    config.corruptPerMille = corruptPerMille;
+    config.seed = 7;
+    session->simulator.begin(config);
+    session->sensor.begin(&session->simulator.getModuleStream());
+    session->sensor.setDelay(1);
+  }
+
+  void run(uint32_t ms)
+  {
+    uint32_t end = millis() + ms;
+    while (static_cast<int32_t>(millis() - end) < 0)
+    {
+      session->simulator.poll();
+      session->sensor.loop();
+    }
+  }
+
+  void runUntilInitialized()
+  {
+    for (int i = 0; i < 10000 && !session->sensor.isVerified(); i++)
+    {
+      run(1);
+    }
+    TEST_ASSERT_TRUE(session->sensor.isVerified());
+  }
+
+  void runUntilIdle(uint32_t maxMs)
+  {
+    for (uint32_t i = 0; i < maxMs && session->sensor.getOta().isActive(); i++)
+    {
+      run(1);
+    }
+  }
+
+  uint32_t crc32(const uint8_t *data, uint32_t length)
+  {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < length; i++)
+    {
+      crc ^= data[i];
+      for (uint8_t bit = 0; bit < 8; bit++)
+        crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+  }
+}
+
+void setUp()
+{
+  for (uint32_t i = 0; i < IMAGE_SIZE; i++)
+  {
+    image[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+}
+
+void tearDown()
+{
+  delete session;
+  session = nullptr;
+}
+
+void test_ota_memory_source_completes()
+{
+  setUpLink(0);
+  runUntilInitialized();
+
+  TuyaOtaMemorySource source(image, IMAGE_SIZE);
+  TEST_ASSERT_TRUE(session->sensor.startOta(source));
+  runUntilIdle(60000);
+
+  const TuyaOta &ota = session->sensor.getOta();
+  TEST_ASSERT_EQUAL(TuyaOtaState::Done, ota.getState());
+  TEST_ASSERT_EQUAL(TuyaOtaError::None, ota.getError());
+  TEST_ASSERT_EQUAL_UINT16(256, ota.getPacketSize());
+  TEST_ASSERT_EQUAL_UINT32(IMAGE_SIZE, ota.getAcknowledged());
+  TEST_ASSERT_EQUAL_UINT32(IMAGE_SIZE, session->simulator.getStats().otaBytes);
+  TEST_ASSERT_EQUAL_UINT32(0, ota.getResends());
+  TEST_ASSERT_EQUAL_HEX32(crc32(image, IMAGE_SIZE), ota.getCrc32());
+}
+
+void test_ota_stream_source_completes()
+{
+  setUpLink(0);
+  runUntilInitialized();
+
+  ImageStream stream(image, IMAGE_SIZE, IMAGE_SIZE);
+  static uint8_t buffer[256];
+  TuyaOtaStreamSource source(stream, IMAGE_SIZE, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(session->sensor.startOta(source));
+  runUntilIdle(60000);
+
+  TEST_ASSERT_EQUAL(TuyaOtaState::Done, session->sensor.getOta().getState());
+  TEST_ASSERT_EQUAL_HEX32(crc32(image, IMAGE_SIZE), session->sensor.getOta().getCrc32());
+}
+
+void test_ota_resends_after_lost_acks()
+{
+  // Corrupted MCU bytes lose acknowledgements; the lost packet is resent
+  setUpLink(15);
+  runUntilInitialized();
+
+  TuyaOtaMemorySource source(image, IMAGE_SIZE);
+  TEST_ASSERT_TRUE(session->sensor.startOta(source, 200, 20));
+  runUntilIdle(120000);
+
+  const TuyaOta &ota = session->sensor.getOta();
+  TEST_ASSERT_EQUAL(TuyaOtaState::Done, ota.getState());
+  TEST_ASSERT_GREATER_THAN_UINT32(0, ota.getResends());
+  TEST_ASSERT_EQUAL_UINT32(IMAGE_SIZE, ota.getAcknowledged());
+  TEST_ASSERT_EQUAL_HEX32(crc32(image, IMAGE_SIZE), ota.getCrc32());
+}
+
+void test_ota_abort()
+{
+  setUpLink(0);
+  runUntilInitialized();
+
+  TuyaOtaMemorySource source(image, IMAGE_SIZE);
+  TEST_ASSERT_TRUE(session->sensor.startOta(source));
+  run(4);
+  TEST_ASSERT_TRUE(session->sensor.getOta().isActive());
+  TEST_ASSERT_GREATER_THAN_UINT32(0, session->sensor.getOta().getAcknowledged());
+
+  // The packet already on the wire still arrives; nothing is sent after it
+  session->sensor.abortOta();
+  run(10);
+  uint32_t sent = session->simulator.getStats().otaBytes;
+  run(1000);
+
+  TEST_ASSERT_EQUAL(TuyaOtaState::Failed, session->sensor.getOta().getState());
+  TEST_ASSERT_EQUAL(TuyaOtaError::Aborted, session->sensor.getOta().getError());
+  TEST_ASSERT_LESS_THAN_UINT32(IMAGE_SIZE, session->sensor.getOta().getAcknowledged());
+  TEST_ASSERT_EQUAL_UINT32(sent, session->simulator.getStats().otaBytes);
+}
+
+void test_ota_rejects_source_smaller_than_packet()
+{
+  setUpLink(0);
+  runUntilInitialized();
+
+  ImageStream stream(image, IMAGE_SIZE, IMAGE_SIZE);
+  static uint8_t buffer[200];
+  TuyaOtaStreamSource source(stream, IMAGE_SIZE, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(session->sensor.startOta(source));
+  runUntilIdle(60000);
+
+  TEST_ASSERT_EQUAL(TuyaOtaState::Failed, session->sensor.getOta().getState());
+  TEST_ASSERT_EQUAL(TuyaOtaError::SourceTooSmall, session->sensor.getOta().getError());
+  TEST_ASSERT_EQUAL_UINT32(0, session->simulator.getStats().otaBytes);
+}
+
+void test_ota_fails_when_source_runs_dry()
+{
+  setUpLink(0);
+  runUntilInitialized();
+
+  ImageStream stream(image, IMAGE_SIZE, 1000);
+  static uint8_t buffer[256];
+  TuyaOtaStreamSource source(stream, IMAGE_SIZE, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(session->sensor.startOta(source, 500));
+  runUntilIdle(60000);
+
+  TEST_ASSERT_EQUAL(TuyaOtaState::Failed, session->sensor.getOta().getState());
+  TEST_ASSERT_EQUAL(TuyaOtaError::SourceStalled, session->sensor.getOta().getError());
+  TEST_ASSERT_EQUAL_UINT32(768, session->sensor.getOta().getAcknowledged());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ota_memory_source_completes);
+  RUN_TEST(test_ota_stream_source_completes);
+  RUN_TEST(test_ota_resends_after_lost_acks);
+  RUN_TEST(test_ota_abort);
+  RUN_TEST(test_ota_rejects_source_smaller_than_packet);
+  RUN_TEST(test_ota_fails_when_source_runs_dry);
+  return UNITY_END();
+}
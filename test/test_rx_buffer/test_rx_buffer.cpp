@@ -0,0 +1,143 @@
+#include <unity.h>
+#include <tuya_rx_buffer.h>
+
+// Byte ring between the UART producer and loop(). Run with `pio test -e native`.
+
+namespace
+{
+  // Serves a fixed byte array once
+  class ArrayStream : public Stream
+  {
+  public:
+    ArrayStream(const uint8_t *data, size_t length) : _data(data), _length(length), _position(0) {}
+
+    int available() override { return static_cast<int>(_length - _position); }
+    int read() override { return available() > 0 ? _data[_position++] : -1; }
+    int peek() override { return available() > 0 ? _data[_position] : -1; }
+    size_t write(uint8_t) override { return 0; }
+
+  private:
+    const uint8_t *_data;
+    size_t _length;
+    size_t _position;
+  };
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_wraparound_keeps_order()
+{
+  uint8_t storage[8];
+  TuyaRxBuffer buffer(storage, sizeof(storage));
+
+  // 5-byte writes and reads walk the indices across the end of storage
+  uint8_t next = 0;
+  uint8_t expected = 0;
+  for (int round = 0; round < 50; round++)
+  {
+    uint8_t in[5];
+    for (uint8_t &byte : in)
+      byte = next++;
+    TEST_ASSERT_EQUAL_UINT32(5, buffer.push(in, sizeof(in)));
+
+    uint8_t out[5];
+    TEST_ASSERT_EQUAL_UINT32(5, buffer.read(out, sizeof(out)));
+    for (uint8_t byte : out)
+      TEST_ASSERT_EQUAL_HEX8(expected++, byte);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, buffer.available());
+  TEST_ASSERT_EQUAL_UINT32(0, buffer.getOverruns());
+}
+
+void test_overflow_is_counted()
+{
+  uint8_t storage[8];
+  TuyaRxBuffer buffer(storage, sizeof(storage));
+  uint8_t in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+  TEST_ASSERT_EQUAL_UINT32(8, buffer.push(in, sizeof(in)));
+  TEST_ASSERT_EQUAL_UINT32(2, buffer.getOverruns());
+  TEST_ASSERT_FALSE(buffer.push(static_cast<uint8_t>(10)));
+  TEST_ASSERT_EQUAL_UINT32(3, buffer.getOverruns());
+
+  // The bytes that fit are intact; the overflow is lost, not overwritten
+  uint8_t out[8];
+  TEST_ASSERT_EQUAL_UINT32(8, buffer.read(out, sizeof(out)));
+  for (uint8_t i = 0; i < 8; i++)
+    TEST_ASSERT_EQUAL_HEX8(i, out[i]);
+}
+
+void test_high_watermark()
+{
+  uint8_t storage[16];
+  TuyaRxBuffer buffer(storage, sizeof(storage));
+  uint8_t in[6] = {};
+  uint8_t out[6];
+
+  buffer.push(in, 6);
+  buffer.read(out, 4);
+  buffer.push(in, 3);
+  TEST_ASSERT_EQUAL_UINT32(6, buffer.getHighWatermark());
+  buffer.push(in, 6);
+  TEST_ASSERT_EQUAL_UINT32(11, buffer.getHighWatermark());
+
+  buffer.resetStatistics();
+  TEST_ASSERT_EQUAL_UINT32(0, buffer.getHighWatermark());
+  buffer.push(static_cast<uint8_t>(0));
+  TEST_ASSERT_EQUAL_UINT32(12, buffer.getHighWatermark());
+}
+
+void test_capacity_rounds_down_to_power_of_two()
+{
+  uint8_t storage[100];
+  TuyaRxBuffer buffer(storage, sizeof(storage));
+  TEST_ASSERT_EQUAL_UINT32(64, buffer.getCapacity());
+
+  uint8_t in[60];
+  for (uint8_t i = 0; i < sizeof(in); i++)
+    in[i] = i * 3;
+  for (int round = 0; round < 3; round++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(sizeof(in), buffer.push(in, sizeof(in)));
+    uint8_t out[60];
+    TEST_ASSERT_EQUAL_UINT32(sizeof(out), buffer.read(out, sizeof(out)));
+    for (uint8_t i = 0; i < sizeof(out); i++)
+      TEST_ASSERT_EQUAL_HEX8(in[i], out[i]);
+  }
+
+  TuyaRxBuffer empty(storage, 0);
+  TEST_ASSERT_EQUAL_UINT32(0, empty.getCapacity());
+  TEST_ASSERT_FALSE(empty.push(static_cast<uint8_t>(1)));
+  TEST_ASSERT_EQUAL_UINT32(0, empty.push(in, 4));
+}
+
+void test_pump_drains_stream_until_full()
+{
+  uint8_t data[40];
+  for (uint8_t i = 0; i < sizeof(data); i++)
+    data[i] = i;
+  ArrayStream stream(data, sizeof(data));
+  uint8_t storage[32];
+  TuyaRxBuffer buffer(storage, sizeof(storage));
+
+  TEST_ASSERT_EQUAL_UINT32(32, buffer.pump(stream));
+  TEST_ASSERT_EQUAL_UINT32(8, buffer.getOverruns());
+  TEST_ASSERT_EQUAL_UINT32(32, buffer.available());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_wraparound_keeps_order);
+  RUN_TEST(test_overflow_is_counted);
+  RUN_TEST(test_high_watermark);
+  RUN_TEST(test_capacity_rounds_down_to_power_of_two);
+  RUN_TEST(test_pump_drains_stream_until_full);
+  return UNITY_END();
+}
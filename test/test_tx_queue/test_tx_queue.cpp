@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <tuya.h>
+
+// Pacing and eviction of the transmit queue. Run with `pio test -e native`.
+
+namespace
+{
+  typedef TuyaTxQueue<TuyaTxFrame, 4> Queue;
+
+  TuyaTxFrame makeFrame(TuyaCommand command, uint8_t dp = 0, uint16_t length = 0)
+  {
+    TuyaTxFrame frame = {};
+    frame.header[0] = 0x55;
+    frame.header[1] = 0xAA;
+    frame.command = static_cast<uint8_t>(command);
+    frame.length[0] = length >> 8;
+    frame.length[1] = length;
+    if (length > 0)
+      frame.data[0] = dp;
+    return frame;
+  }
+
+  // Bytes the queue lets through in `seconds` with a frame always waiting
+  uint32_t sentBytes(uint16_t bytesPerSecond, uint32_t seconds)
+  {
+    Queue queue;
+    queue.setRate(bytesPerSecond, 0);
+    TuyaTxFrame frame = makeFrame(TuyaCommand::SendCommand, 0x6B, 8);
+    TuyaTxFrame sent;
+    uint32_t bytes = 0;
+    uint32_t start = millis();
+    for (uint32_t ms = 0; ms < seconds * 1000; ms++)
+    {
+      if (queue.getCount() == 0)
+        queue.push(frame, TuyaTxPriority::Normal);
+      while (queue.pop(start + ms, sent))
+        bytes += 15;
+    }
+    return bytes;
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_rate_is_exact_for_any_bytes_per_second()
+{
+  // Truncated refills used to send 500, 1000 and 333 bytes/s for these
+  const uint16_t rates[] = {480, 960, 300, 7};
+  for (uint16_t rate : rates)
+  {
+    uint32_t bytes = sentBytes(rate, 100);
+    uint32_t expected = rate * 100;
+    // One burst (a full frame here) up front, one frame of rounding at the end
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(expected + 39 + 15, bytes);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(expected - 15, bytes);
+  }
+}
+
+void test_dp_writes_are_never_evicted()
+{
+  Queue queue;
+  queue.setRate(0, 0);
+  for (uint8_t dp = 0x66; dp < 0x69; dp++)
+  {
+    TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::SendCommand, dp, 8), TuyaTxPriority::Normal));
+  }
+
+  // The last slot is kept for high priority: a fourth write is refused
+  // instead of taking it, and a heartbeat still gets in
+  TEST_ASSERT_FALSE(queue.push(makeFrame(TuyaCommand::SendCommand, 0x69, 8), TuyaTxPriority::Normal));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.getStats().dropped);
+  TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::Heartbeats), TuyaTxPriority::High));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.getStats().dropped);
+
+  TuyaTxFrame frame;
+  TEST_ASSERT_TRUE(queue.pop(millis(), frame));
+  TEST_ASSERT_EQUAL_HEX8(static_cast<uint8_t>(TuyaCommand::Heartbeats), frame.command);
+  for (uint8_t dp = 0x66; dp < 0x69; dp++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(millis(), frame));
+    TEST_ASSERT_EQUAL_HEX8(dp, frame.data[0]);
+  }
+  TEST_ASSERT_FALSE(queue.pop(millis(), frame));
+}
+
+void test_queries_are_evicted_for_higher_priority()
+{
+  Queue queue;
+  queue.setRate(0, 0);
+  TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::QueryDpStatus), TuyaTxPriority::Low));
+  TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::SendCommand, 0x66, 8), TuyaTxPriority::Normal));
+  TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::SendCommand, 0x67, 8), TuyaTxPriority::Normal));
+
+  // The third write takes the query's slot, not the reserved one
+  TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::SendCommand, 0x68, 8), TuyaTxPriority::Normal));
+  TEST_ASSERT_EQUAL_UINT32(3, queue.getCount());
+  TEST_ASSERT_TRUE(queue.push(makeFrame(TuyaCommand::Heartbeats), TuyaTxPriority::High));
+
+  TuyaTxFrame frame;
+  TEST_ASSERT_TRUE(queue.pop(millis(), frame));
+  TEST_ASSERT_EQUAL_HEX8(static_cast<uint8_t>(TuyaCommand::Heartbeats), frame.command);
+  uint8_t writes = 0;
+  while (queue.pop(millis(), frame))
+  {
+    TEST_ASSERT_EQUAL_HEX8(static_cast<uint8_t>(TuyaCommand::SendCommand), frame.command);
+    writes++;
+  }
+  TEST_ASSERT_EQUAL_UINT8(3, writes);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_rate_is_exact_for_any_bytes_per_second);
+  RUN_TEST(test_dp_writes_are_never_evicted);
+  RUN_TEST(test_queries_are_evicted_for_higher_priority);
+  return UNITY_END();
+}
@@ -0,0 +1,375 @@
+#include <unity.h>
+#include <tuya_water_quality.h>
+#include <tuya_mcu_simulator.h>
+
+// Decoding of ReportStatusAsync frames and the requests they resolve. Run
+// with `pio test -e native`.
+
+namespace
+{
+  // Exposes the protected decoder so frames can be fed without a link
+  class TestWaterQuality : public TuyaWaterQuality
+  {
+  public:
+    using TuyaWaterQuality::decodeReportStatusAsync;
+  };
+
+  struct EventLog
+  {
+    uint8_t count;
+    uint8_t dps[8];
+    TuyaEventType types[8];
+  };
+
+  void logEvent(void *context, const TuyaEvent &event)
+  {
+    EventLog &log = *static_cast<EventLog *>(context);
+    if (log.count < sizeof(log.dps))
+    {
+      log.dps[log.count] = event.dp;
+      log.types[log.count] = event.type;
+    }
+    log.count++;
+  }
+
+  void fillFrame(TuyaFrame &frame, const uint8_t *data, uint16_t length)
+  {
+    frame.header[0] = 0x55;
+    frame.header[1] = 0xAA;
+    frame.version = 0x03;
+    frame.command = static_cast<uint8_t>(TuyaCommand::ReportStatusAsync);
+    frame.length[0] = length >> 8;
+    frame.length[1] = length;
+    memcpy(frame.data, data, length);
+  }
+
+  TuyaFrame frame;
+
+  uint8_t sensorDataCalls;
+
+  void countSensorData(TuyaWaterQualitySensorData &)
+  {
+    sensorDataCalls++;
+  }
+
+  void fillValueReport(TuyaFrame &frame, TuyaWaterQualityDp dp, int32_t value)
+  {
+    const uint8_t data[] = {
+        static_cast<uint8_t>(dp), 0x02, 0x00, 0x04,
+        static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    fillFrame(frame, data, sizeof(data));
+  }
+
+  struct Link
+  {
+    TuyaMcuSimulator simulator;
+    TestWaterQuality sensor;
+  };
+
+  Link *setUpLink()
+  {
+    Link *link = new Link();
+    TuyaMcuSimulatorConfig config = {};
+    config.productInfo = "{\"product_id\":\"simulated\",\"version\":\"1.0.0\",\"operation_mode\":1}";
+    link->simulator.begin(config);
+    link->simulator.addDp(static_cast<uint8_t>(TuyaWaterQualityDp::HighPHThreshold), 800, 0);
+    link->sensor.begin(&link->simulator.getModuleStream());
+    link->sensor.setDelay(1);
+    return link;
+  }
+
+  void runUntilResolved(Link &link, const TuyaRequest &request)
+  {
+    for (int i = 0; i < 10000 && request.isPending(); i++)
+    {
+      link.simulator.poll();
+      link.sensor.loop();
+    }
+  }
+
+#if TUYA_HAS_COROUTINES
+  struct Chain
+  {
+    TuyaRequestState setterState;
+    TuyaRequestState queryState;
+    uint32_t setterGeneration;
+    uint32_t queryGeneration;
+    bool done;
+  };
+
+  TuyaTask setThenQuery(TestWaterQuality &sensor, Chain &chain)
+  {
+    chain.setterState = co_await sensor.setMaxPhAsync(8.2);
+    chain.setterGeneration = sensor.getSnapshotGeneration();
+    chain.queryState = co_await sensor.queryStatusAsync(TuyaWaterQualityDp::HighPHThreshold);
+    chain.queryGeneration = sensor.getSnapshotGeneration();
+    chain.done = true;
+  }
+#endif
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_single_dp_report()
+{
+  TestWaterQuality sensor;
+  const uint8_t data[] = {0x08, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0xFD};
+  fillFrame(frame, data, sizeof(data));
+
+  TEST_ASSERT_TRUE(sensor.decodeReportStatusAsync(frame));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 25.3, sensor.getTemperature());
+  TEST_ASSERT_EQUAL_UINT32(1, sensor.getSnapshotGeneration());
+}
+
+void test_multi_dp_report_decodes_every_dp()
+{
+  TestWaterQuality sensor;
+  // Temperature 25.3, pH 7.01, TDS 300 and the high pH threshold 8.20
+  const uint8_t data[] = {
+      0x08, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0xFD,
+      0x6A, 0x02, 0x00, 0x04, 0x00, 0x00, 0x02, 0xBD,
+      0x6F, 0x02, 0x00, 0x04, 0x00, 0x00, 0x01, 0x2C,
+      0x6B, 0x02, 0x00, 0x04, 0x00, 0x00, 0x03, 0x34};
+  fillFrame(frame, data, sizeof(data));
+
+  EventLog log = {};
+  sensor.subscribe(TUYA_EVENT_MASK_ALL, logEvent, &log);
+  sensor.onSensorData(countSensorData);
+  sensorDataCalls = 0;
+  TEST_ASSERT_TRUE(sensor.decodeReportStatusAsync(frame));
+
+  // The frame is published once, with all of its DPs applied
+  TEST_ASSERT_EQUAL_UINT32(1, sensor.getSnapshotGeneration());
+  TEST_ASSERT_EQUAL_UINT8(1, sensorDataCalls);
+  TuyaWaterQualitySnapshot snapshot;
+  sensor.getSnapshot(snapshot);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 25.3, snapshot.data.temperature.value);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 8.2, snapshot.data.ph.maxThreshold);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 25.3, sensor.getTemperature());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.01, sensor.getPh());
+  TEST_ASSERT_EQUAL_INT32(300, sensor.getTds());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 8.2, sensor.getMaxPh());
+
+  TEST_ASSERT_EQUAL_UINT8(4, log.count);
+  TEST_ASSERT_EQUAL_HEX8(0x08, log.dps[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x6A, log.dps[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x6F, log.dps[2]);
+  TEST_ASSERT_EQUAL_HEX8(0x6B, log.dps[3]);
+  TEST_ASSERT_EQUAL(TuyaEventType::ThresholdChange, log.types[3]);
+}
+
+void test_unknown_dp_is_published_raw()
+{
+  TestWaterQuality sensor;
+  // A bool DP the sensor class does not know, followed by a TDS reading
+  const uint8_t data[] = {
+      0x01, 0x01, 0x00, 0x01, 0x01,
+      0x6F, 0x02, 0x00, 0x04, 0x00, 0x00, 0x01, 0x2C};
+  fillFrame(frame, data, sizeof(data));
+
+  EventLog log = {};
+  sensor.subscribe(TUYA_EVENT_MASK_ALL, logEvent, &log);
+  TEST_ASSERT_TRUE(sensor.decodeReportStatusAsync(frame));
+
+  TEST_ASSERT_EQUAL_UINT8(2, log.count);
+  TEST_ASSERT_EQUAL_HEX8(0x01, log.dps[0]);
+  TEST_ASSERT_EQUAL(TuyaEventType::DpUpdate, log.types[0]);
+  TEST_ASSERT_EQUAL_INT32(300, sensor.getTds());
+}
+
+void test_truncated_report_is_rejected()
+{
+  TestWaterQuality sensor;
+  // The second DP claims four bytes but only two follow
+  const uint8_t data[] = {
+      0x08, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0xFD,
+      0x6A, 0x02, 0x00, 0x04, 0x00, 0x00};
+  fillFrame(frame, data, sizeof(data));
+
+  TEST_ASSERT_FALSE(sensor.decodeReportStatusAsync(frame));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 25.3, sensor.getTemperature());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 0, sensor.getPh());
+}
+
+void test_setter_rounds_to_fixed_point()
+{
+  // 8.2 * 100 is 819.999...; truncating would send and confirm 8.19
+  Link *link = setUpLink();
+  TuyaRequest request = link->sensor.setMaxPhAsync(8.2);
+  runUntilResolved(*link, request);
+
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, request.getState());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 8.2, request.getValue());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 8.2, link->sensor.getMaxPh());
+  delete link;
+}
+
+void test_setter_ignores_report_of_old_value()
+{
+  Link *link = setUpLink();
+  TuyaRequest request = link->sensor.setMaxPhAsync(8.2);
+
+  // An unsolicited report of the previous threshold arrives first
+  fillValueReport(frame, TuyaWaterQualityDp::HighPHThreshold, 800);
+  TEST_ASSERT_TRUE(link->sensor.decodeReportStatusAsync(frame));
+  TEST_ASSERT_TRUE(request.isPending());
+
+  runUntilResolved(*link, request);
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, request.getState());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 8.2, request.getValue());
+  delete link;
+}
+
+void test_query_resolves_on_any_value()
+{
+  Link *link = setUpLink();
+  TuyaRequest request = link->sensor.queryStatusAsync(TuyaWaterQualityDp::HighPHThreshold);
+
+  fillValueReport(frame, TuyaWaterQualityDp::HighPHThreshold, 750);
+  TEST_ASSERT_TRUE(link->sensor.decodeReportStatusAsync(frame));
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, request.getState());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.5, request.getValue());
+  delete link;
+}
+
+void test_no_command_sent_without_free_request_slot()
+{
+  Link *link = setUpLink();
+  TuyaRequest requests[TUYA_MAX_PENDING_REQUESTS];
+  const TuyaWaterQualityDp dps[] = {
+      TuyaWaterQualityDp::HighPHThreshold, TuyaWaterQualityDp::LowPHThreshold,
+      TuyaWaterQualityDp::HighTemperatureThreshold, TuyaWaterQualityDp::LowTemperatureThreshold};
+  for (uint8_t i = 0; i < TUYA_MAX_PENDING_REQUESTS; i++)
+  {
+    requests[i] = link->sensor.queryStatusAsync(dps[i % 4]);
+    TEST_ASSERT_TRUE(requests[i].isPending());
+  }
+  uint8_t queued = link->sensor.getTxStats().queued;
+
+  TuyaRequest rejected = link->sensor.setMaxTdsAsync(500);
+  TEST_ASSERT_EQUAL(TuyaRequestState::Invalid, rejected.getState());
+  TEST_ASSERT_EQUAL_UINT8(queued, link->sensor.getTxStats().queued);
+  delete link;
+}
+
+void test_stale_handle_stays_invalid()
+{
+  Link *link = setUpLink();
+  TuyaRequest first = link->sensor.queryStatusAsync(TuyaWaterQualityDp::HighPHThreshold);
+  fillValueReport(frame, TuyaWaterQualityDp::HighPHThreshold, 750);
+  TEST_ASSERT_TRUE(link->sensor.decodeReportStatusAsync(frame));
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, first.getState());
+
+  // 256 reuses of its slot used to wrap the generation back onto the handle
+  for (uint32_t i = 0; i < 256 * TUYA_MAX_PENDING_REQUESTS; i++)
+  {
+    link->sensor.queryStatusAsync(TuyaWaterQualityDp::HighPHThreshold);
+    TEST_ASSERT_TRUE(link->sensor.decodeReportStatusAsync(frame));
+  }
+  TEST_ASSERT_EQUAL(TuyaRequestState::Invalid, first.getState());
+  delete link;
+}
+
+void test_handshake_fills_product_info()
+{
+  Link *link = setUpLink();
+  for (int i = 0; i < 10000 && !link->sensor.isVerified(); i++)
+  {
+    link->simulator.poll();
+    link->sensor.loop();
+  }
+  TEST_ASSERT_TRUE(link->sensor.isVerified());
+
+  TuyaProductInfo info = link->sensor.getProductInfo();
+  TEST_ASSERT_EQUAL_STRING("simulated", info.productId.c_str());
+  TEST_ASSERT_EQUAL_STRING("1.0.0", info.version.c_str());
+  TEST_ASSERT_EQUAL_UINT16(1, info.operationMode);
+  delete link;
+}
+
+void test_restored_snapshot_is_flagged()
+{
+  static uint32_t words[TuyaStateStore::capacityWords];
+  TuyaMemoryStateStore store(words, TuyaStateStore::capacityWords);
+  store.invalidate();
+
+  // First boot: complete the handshake, take a reading and save it
+  Link *link = setUpLink();
+  link->sensor.setStateStore(&store, 0);
+  for (int i = 0; i < 10000 && !link->sensor.isVerified(); i++)
+  {
+    link->simulator.poll();
+    link->sensor.loop();
+  }
+  TEST_ASSERT_TRUE(link->sensor.isVerified());
+  fillValueReport(frame, TuyaWaterQualityDp::PH, 701);
+  TEST_ASSERT_TRUE(link->sensor.decodeReportStatusAsync(frame));
+  link->sensor.loop();
+  delete link;
+
+  // Second boot: the cached reading is served at once, flagged as restored
+  link = new Link();
+  link->sensor.setStateStore(&store, 0);
+  link->sensor.begin(&link->simulator.getModuleStream());
+  TuyaWaterQualitySnapshot snapshot;
+  link->sensor.getSnapshot(snapshot);
+  TEST_ASSERT_TRUE(snapshot.restored);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.01, snapshot.data.ph.value);
+
+  fillValueReport(frame, TuyaWaterQualityDp::PH, 705);
+  TEST_ASSERT_TRUE(link->sensor.decodeReportStatusAsync(frame));
+  link->sensor.getSnapshot(snapshot);
+  TEST_ASSERT_FALSE(snapshot.restored);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.05, snapshot.data.ph.value);
+  delete link;
+}
+
+#if TUYA_HAS_COROUTINES
+void test_chained_awaits_wait_for_a_new_report()
+{
+  Link *link = setUpLink();
+  Chain chain = {};
+  setThenQuery(link->sensor, chain);
+  for (int i = 0; i < 10000 && !chain.done; i++)
+  {
+    link->simulator.poll();
+    link->sensor.loop();
+  }
+
+  TEST_ASSERT_TRUE(chain.done);
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, chain.setterState);
+  TEST_ASSERT_EQUAL(TuyaRequestState::Done, chain.queryState);
+  // The query is answered by the report to its own command, not by the one
+  // that confirmed the setter
+  TEST_ASSERT_GREATER_THAN_UINT32(chain.setterGeneration, chain.queryGeneration);
+  delete link;
+}
+#endif
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_single_dp_report);
+  RUN_TEST(test_multi_dp_report_decodes_every_dp);
+  RUN_TEST(test_unknown_dp_is_published_raw);
+  RUN_TEST(test_truncated_report_is_rejected);
+  RUN_TEST(test_setter_rounds_to_fixed_point);
+  RUN_TEST(test_setter_ignores_report_of_old_value);
+  RUN_TEST(test_query_resolves_on_any_value);
+  RUN_TEST(test_no_command_sent_without_free_request_slot);
+  RUN_TEST(test_stale_handle_stays_invalid);
+  RUN_TEST(test_handshake_fills_product_info);
+  RUN_TEST(test_restored_snapshot_is_flagged);
+#if TUYA_HAS_COROUTINES
+  RUN_TEST(test_chained_awaits_wait_for_a_new_report);
+#endif
+  return UNITY_END();
+}